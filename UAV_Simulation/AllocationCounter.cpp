@@ -0,0 +1,25 @@
+#include "SimArena.h"
+#include <cstdlib>
+#include <new>
+
+// the global operator new that NoAllocationScope counts with. it is part of the UAV_Simulation program
+// only (not of the uav_sim library), and of its debug builds only
+#ifndef NDEBUG
+
+void* operator new(std::size_t size) {
+	NoAllocationScope::countAllocation();
+	if (void* p = std::malloc((size != 0) ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t size) noexcept {
+	(void)size;
+	std::free(p);
+}
+
+#endif
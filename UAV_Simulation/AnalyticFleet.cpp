@@ -0,0 +1,212 @@
+#include "AnalyticFleet.h"
+#include "Profiler.h"
+
+static const int bisectionSteps = 60; // enough to get any event time down to double precision
+
+AnalyticFleet::AnalyticFleet(const FleetManifest& fleet, double dt)
+	: dt(dt), tracks(fleet.size())
+{
+	for (size_t t = 0; t < fleet.getTypeCount(); t++) {
+		const FleetManifest::Type& type = fleet.getType(t);
+		airframes.push_back({ type.velocity, type.turnRadius, type.velocity / type.turnRadius });
+	}
+	for (size_t i = 0; i < tracks.size(); i++) {
+		const FleetManifest::Placement& start = fleet.getPlacement(i);
+		Track& track = tracks[i];
+		track.clockwise = false;
+		track.airframe = start.type;
+		track.destX = track.destY = 0.;
+		startSegment(track, UAV::State::CRUISE, 0., start.x, start.y, start.radianAngle);
+	}
+}
+
+void AnalyticFleet::evaluate(const Track& track, const double t, double& x, double& y, double& radianAngle) const {
+	const Airframe& airframe = airframes[track.airframe];
+	const double tau = t - track.t0;
+	if (track.state != UAV::State::TURN && track.state != UAV::State::ROTATE) {
+		x = track.x0 + airframe.velocity * tau * cos(track.a0);
+		y = track.y0 + airframe.velocity * tau * sin(track.a0);
+		radianAngle = track.a0;
+		return;
+	}
+	// on a circle: the centre is turnRadius to the left (counter clockwise) or right (clockwise) of the heading
+	const double side = (track.clockwise) ? -1. : 1.;
+	const double angle = track.a0 + side * airframe.omega * tau;
+	const double cX = track.x0 - side * airframe.turnRadius * sin(track.a0);
+	const double cY = track.y0 + side * airframe.turnRadius * cos(track.a0);
+	x = cX + side * airframe.turnRadius * sin(angle);
+	y = cY - side * airframe.turnRadius * cos(angle);
+	// same clamping as UAV::applyAngleChange
+	radianAngle = angle - (2 * M_PI) * floor(angle / (2 * M_PI));
+}
+
+void AnalyticFleet::startSegment(Track& track, const UAV::State state, const double t, const double x, const double y, const double radianAngle) {
+	track.state = state;
+	track.t0 = t;
+	track.x0 = x;
+	track.y0 = y;
+	track.a0 = radianAngle;
+	if (state == UAV::State::ROTATE)
+		track.clockwise = true; // as in UAV::confirmArrival
+	scheduleEvent(track);
+}
+
+void AnalyticFleet::scheduleEvent(Track& track) {
+	track.eventTime = HUGE_VAL;
+	track.nextState = track.state;
+	switch (track.state) {
+	case UAV::State::PREP_TURN: {
+		// the tick loop checks for the tangent first, then whether the turn can start
+		const double tangent = tangentTime(track);
+		const double turn = turnPossibleTime(track);
+		if (tangent <= turn) {
+			track.eventTime = tangent;
+			track.nextState = UAV::State::ROTATE;
+		}
+		else {
+			track.eventTime = turn;
+			track.nextState = UAV::State::TURN;
+		}
+		break;
+	}
+	case UAV::State::HAS_DEST:
+		track.eventTime = tangentTime(track);
+		track.nextState = UAV::State::ROTATE;
+		break;
+	case UAV::State::TURN:
+		track.eventTime = turnEndTime(track);
+		track.nextState = UAV::State::HAS_DEST;
+		break;
+	default:
+		break; // CRUISE and ROTATE go on until the next command
+	}
+}
+
+// straight segment: time of the closest approach to the destination, when it is close enough for
+// confirmArrival to accept it as the tangent point
+double AnalyticFleet::tangentTime(const Track& track) const {
+	const Airframe& airframe = airframes[track.airframe];
+	const double ux = cos(track.a0), uy = sin(track.a0);
+	const double dx = track.destX - track.x0, dy = track.destY - track.y0;
+	const double tau = dotProduct2D(ux, uy, dx, dy) / airframe.velocity;
+	if (tau < -dt)
+		return HUGE_VAL; // moving away from it
+	const double closest = vec2DDist(airframe.velocity * tau * ux, airframe.velocity * tau * uy, dx, dy);
+	if (closest >= (1.4 + dt) * airframe.turnRadius)
+		return HUGE_VAL;
+	return track.t0 + std::max(tau, 0.);
+}
+
+// UAV::turnIsPossible at time t of a straight segment
+bool AnalyticFleet::turnIsPossibleAt(const Track& track, const double t) const {
+	const Airframe& airframe = airframes[track.airframe];
+	double x, y, angle;
+	evaluate(track, t, x, y, angle);
+	if (vec2DDist(track.destX, track.destY, x, y) >= 2 * airframe.turnRadius)
+		return true;
+	const double angleToCircleCenter = (track.clockwise) ? -M_PI_2 : M_PI_2;
+	const double deltaX = track.destX - (x + airframe.turnRadius * cos(angleToCircleCenter + angle));
+	const double deltaY = track.destY - (y + airframe.turnRadius * sin(angleToCircleCenter + angle));
+	return (deltaX * deltaX + deltaY * deltaY) >= airframe.turnRadius;
+}
+
+// first time the turn can start, scanning ahead in steps of 1/8 of the turn radius
+double AnalyticFleet::turnPossibleTime(const Track& track) const {
+	const Airframe& airframe = airframes[track.airframe];
+	if (turnIsPossibleAt(track, track.t0))
+		return track.t0;
+	const double step = airframe.turnRadius / (8 * airframe.velocity);
+	// once further than 2R away (at the latest after flying past the destination) any turn is possible
+	const double horizon = track.t0 + (vec2DDist(track.x0, track.y0, track.destX, track.destY) + 2 * airframe.turnRadius) / airframe.velocity + step;
+	double before = track.t0;
+	for (double t = track.t0 + step; t <= horizon; t += step) {
+		if (turnIsPossibleAt(track, t)) {
+			double after = t;
+			for (int i = 0; i < bisectionSteps; i++) {
+				const double mid = 0.5 * (before + after);
+				if (turnIsPossibleAt(track, mid))
+					after = mid;
+				else
+					before = mid;
+			}
+			return after;
+		}
+		before = t;
+	}
+	return horizon;
+}
+
+// turning: time the heading reaches the angle turnLogic aims for (HUGE_VAL if it never does - like
+// the tick loop, the comparison is on the raw clamped values, without wrapping the difference)
+double AnalyticFleet::turnEndTime(const Track& track) const {
+	const Airframe& airframe = airframes[track.airframe];
+	const auto headingError = [&](const double t) {
+		double x, y, angle;
+		evaluate(track, t, x, y, angle);
+		const double dx = track.destX - x, dy = track.destY - y;
+		const double theta = asin(airframe.turnRadius / sqrt(dx * dx + dy * dy));
+		return angle - ((getAngleBetweenTwoVectors(1., 0., dx, dy) * M_PI / 180.) + theta);
+	};
+	double previous = headingError(track.t0);
+	if (fabs(previous) <= dt * airframe.velocity / airframe.turnRadius)
+		return track.t0;
+	// one full circle, half a degree of heading per step
+	const double period = 2 * M_PI / airframe.omega;
+	const double step = period / 720;
+	double before = track.t0;
+	for (double t = track.t0 + step; t <= track.t0 + period + step; t += step) {
+		const double current = headingError(t);
+		// a sign change that is not one of the angles wrapping around 2*pi
+		if ((previous < 0) != (current < 0) && fabs(current - previous) < M_PI) {
+			double after = t;
+			const bool startNegative = previous < 0;
+			for (int i = 0; i < bisectionSteps; i++) {
+				const double mid = 0.5 * (before + after);
+				if ((headingError(mid) < 0) == startNegative)
+					before = mid;
+				else
+					after = mid;
+			}
+			return after;
+		}
+		previous = current;
+		before = t;
+	}
+	return HUGE_VAL;
+}
+
+void AnalyticFleet::advanceTo(const size_t i, const double t) {
+	Track& track = tracks[i];
+	while (track.eventTime <= t) {
+		double x, y, angle;
+		evaluate(track, track.eventTime, x, y, angle);
+		if (track.nextState == UAV::State::ROTATE && _VERBOSE)
+			std::cout << "Arrived at tangent!\n";
+		PROFILE_TRANSITION(track.nextState);
+		startSegment(track, track.nextState, track.eventTime, x, y, angle);
+	}
+}
+
+void AnalyticFleet::acceptCommand(const Command& command, const double currentTime) {
+	const size_t i = command.getUavNum();
+	advanceTo(i, currentTime);
+	Track& track = tracks[i];
+	double x, y, angle;
+	evaluate(track, currentTime, x, y, angle);
+	track.destX = command.getX();
+	track.destY = command.getY();
+	// same rule as UAV::acceptCommand
+	const double angleBetweenVectors = getAngleBetweenTwoVectors(cos(angle), sin(angle), track.destX - x, track.destY - y);
+	track.clockwise = (angleBetweenVectors - angle > 180);
+	if (_VERBOSE)
+		std::cout << "UAV#" << i << " received command to move to : " << track.destX << ", " << track.destY << "\n";
+	PROFILE_TRANSITION(UAV::State::PREP_TURN);
+	startSegment(track, UAV::State::PREP_TURN, currentTime, x, y, angle);
+}
+
+void AnalyticFleet::sample(const size_t i, const double t, double& x, double& y, double& radianAngle, UAV::State& state, bool& clockwise) {
+	advanceTo(i, t);
+	evaluate(tracks[i], t, x, y, radianAngle);
+	state = tracks[i].state;
+	clockwise = tracks[i].clockwise;
+}
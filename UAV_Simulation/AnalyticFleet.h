@@ -0,0 +1,68 @@
+#ifndef ANALYTIC_FLEET_H
+#define ANALYTIC_FLEET_H
+
+#include "project_headers.h"
+#include "Command.h"
+#include "UAV.h"
+#include "FleetManifest.h"
+#include "uav_utilities.h"
+
+// Event-driven version of the UAV flight logic. every state flies either a straight line
+// (CRUISE, HAS_DEST, PREP_TURN) or a circle of radius turnRadius at constant omega (TURN, ROTATE),
+// so instead of integrating with Euler steps each UAV keeps the start of its current segment and the
+// time of the event that ends it:
+//  - PREP_TURN: the first moment turnIsPossible() holds (-> TURN), or the tangent point (-> ROTATE)
+//  - HAS_DEST:  the closest approach to the destination, if within the confirmArrival range (-> ROTATE)
+//  - TURN:      the moment the heading reaches the turnLogic proposed angle (-> HAS_DEST)
+//  - CRUISE / ROTATE: none, only a new command ends them
+// positions are only evaluated when a sample is asked for, work is O(events + samples) instead of
+// O(ticks * UAVs). events are found exactly (closest approach in closed form, the others by scanning
+// and bisection), so results differ from the tick engines by their per-tick resolution: a turn or
+// tangent event the tick loop detects up to one tick early/late, i.e. up to omega * Dt of heading.
+class AnalyticFleet {
+private:
+	struct Airframe {
+		double velocity, turnRadius, omega;
+	};
+	struct Track {
+		UAV::State state;
+		bool clockwise;
+		uint16_t airframe;      // index into airframes
+		double t0, x0, y0, a0;  // start of the current segment
+		double destX, destY;
+		double eventTime;       // end of the current segment (HUGE_VAL if none)
+		UAV::State nextState;   // state after eventTime
+	};
+
+	double dt;
+	std::vector<Airframe> airframes; // per type
+	std::vector<Track> tracks;
+
+	// position and heading of a track at time t (t within its current segment)
+	void evaluate(const Track& track, const double t, double& x, double& y, double& radianAngle) const;
+
+	// move a track to time t, through every event on the way
+	void advanceTo(const size_t i, const double t);
+
+	// start a new segment at time t in the given state, and find its ending event
+	void startSegment(Track& track, const UAV::State state, const double t, const double x, const double y, const double radianAngle);
+	void scheduleEvent(Track& track);
+
+	double tangentTime(const Track& track) const;
+	double turnPossibleTime(const Track& track) const;
+	double turnEndTime(const Track& track) const;
+	bool turnIsPossibleAt(const Track& track, const double t) const;
+
+public:
+	AnalyticFleet(const FleetManifest& fleet, double dt);
+
+	// command applied at the tick starting at currentTime
+	void acceptCommand(const Command& command, const double currentTime);
+
+	// state of UAV i at time t (t must not go back in time for that UAV)
+	void sample(const size_t i, const double t, double& x, double& y, double& radianAngle, UAV::State& state, bool& clockwise);
+
+	size_t size() const { return tracks.size(); }
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include "AsyncTextTrajectorySink.h"
+#include "TextTrajectorySink.h"
+#include "Profiler.h"
+#include <charconv>
+#include <chrono>
+
+static const size_t flushBudget = 1 << 26;  // total text buffered over all UAVs (64 MB)
+static const size_t ringBudget = 1 << 21;   // default total records over all rings (64 MB)
+
+// round up to the next power of two (so ring indices are a mask away)
+static size_t roundUpPow2(size_t n) {
+	size_t p = 1;
+	while (p < n)
+		p <<= 1;
+	return p;
+}
+
+size_t AsyncTextTrajectorySink::ringCapacityFor(const size_t uavCount, const size_t ringCapacity) {
+	return roundUpPow2((ringCapacity != 0) ? ringCapacity : std::clamp<size_t>(ringBudget / std::max<size_t>(uavCount, 1), 64, 8192));
+}
+
+// a share of the text budget per UAV, at least a few lines and at most 64 KB blocks
+size_t AsyncTextTrajectorySink::flushSizeFor(const size_t uavCount) {
+	return std::clamp<size_t>(flushBudget / std::max<size_t>(uavCount, 1), 1 << 10, 1 << 16);
+}
+
+size_t AsyncTextTrajectorySink::memoryBytes(const size_t uavCount, const size_t ringCapacity) {
+	return uavCount * ringCapacityFor(uavCount, ringCapacity) * sizeof(TrajectoryRecord);
+}
+
+AsyncTextTrajectorySink::AsyncTextTrajectorySink(const size_t uavCount, const std::string& directory, const size_t ringCapacity,
+	const std::vector<uint64_t>* resumeOffsets, std::pmr::memory_resource* resource)
+	: uavCount(uavCount),
+	ringCapacity(ringCapacityFor(uavCount, ringCapacity)),
+	rings(uavCount * this->ringCapacity, resource), heads(uavCount), tails(uavCount), cachedTails(uavCount, 0),
+	streams(uavCount), pending(uavCount), flushSize(flushSizeFor(uavCount)), checkpointRequest(0), checkpointDone(0), checkpointOffsets(uavCount, 0),
+	closing(false), closed(false)
+{
+	for (size_t i = 0; i < uavCount; i++) {
+		// text mode, so line endings match TextTrajectorySink on every platform
+		TextTrajectorySink::openFile(streams[i], directory, i, resumeOffsets);
+		pending[i].reserve(flushSize);
+	}
+	writer = std::thread(&AsyncTextTrajectorySink::writerLoop, this);
+}
+
+AsyncTextTrajectorySink::~AsyncTextTrajectorySink() {
+	close();
+}
+
+size_t AsyncTextTrajectorySink::formatLine(char* out, const TrajectoryRecord& sample) {
+	char* const end = out + maxLineLength;
+	char* p = out;
+	p = std::to_chars(p, end, sample.time, std::chars_format::fixed, 2).ptr;
+	*p++ = ' ';
+	p = std::to_chars(p, end, sample.x, std::chars_format::fixed, 2).ptr;
+	*p++ = ' ';
+	p = std::to_chars(p, end, sample.y, std::chars_format::fixed, 2).ptr;
+	*p++ = ' ';
+	p = std::to_chars(p, end, sample.radianAngle * 180. / M_PI, std::chars_format::fixed, 2).ptr;
+	*p++ = '\n';
+	return p - out;
+}
+
+void AsyncTextTrajectorySink::record(const size_t uavNum, const double time, const double x, const double y, const double radianAngle) {
+	const size_t head = heads[uavNum].load(std::memory_order_relaxed);
+	if (head - cachedTails[uavNum] == ringCapacity) {
+		// ring looks full - see how far the writer got, and wait for it if needed
+		while ((cachedTails[uavNum] = tails[uavNum].load(std::memory_order_acquire)) + ringCapacity == head)
+			std::this_thread::yield();
+	}
+	rings[uavNum * ringCapacity + (head & (ringCapacity - 1))] = { time, x, y, radianAngle };
+	heads[uavNum].store(head + 1, std::memory_order_release);
+}
+
+// move everything currently in the ring of uavNum into its text buffer, returns false if it was empty
+bool AsyncTextTrajectorySink::drain(const size_t uavNum) {
+	const size_t head = heads[uavNum].load(std::memory_order_acquire);
+	size_t tail = tails[uavNum].load(std::memory_order_relaxed);
+	if (tail == head)
+		return false;
+	std::string& text = pending[uavNum];
+	char line[maxLineLength];
+	for (; tail != head; tail++) {
+		const size_t length = formatLine(line, rings[uavNum * ringCapacity + (tail & (ringCapacity - 1))]);
+		// flush first, so the text stays within what was reserved
+		if (text.size() + length > flushSize)
+			flush(uavNum);
+		text.append(line, length);
+	}
+	tails[uavNum].store(tail, std::memory_order_release);
+	return true;
+}
+
+void AsyncTextTrajectorySink::flush(const size_t uavNum) {
+	std::string& text = pending[uavNum];
+	if (!text.empty()) {
+		streams[uavNum].write(text.data(), text.size());
+		PROFILE_COUNT(COUNT_BYTES, text.size());
+		text.clear();
+	}
+}
+
+void AsyncTextTrajectorySink::writerLoop() {
+	while (true) {
+		// read the flag before draining, so a final pass always follows the last record
+		const bool finishing = closing.load(std::memory_order_acquire);
+		const size_t request = checkpointRequest.load(std::memory_order_acquire);
+		bool progressed = false;
+		for (size_t i = 0; i < uavCount; i++) {
+			progressed |= drain(i);
+		}
+		if (request != checkpointDone.load(std::memory_order_relaxed)) {
+			for (size_t i = 0; i < uavCount; i++) {
+				flush(i);
+				streams[i].flush();
+				checkpointOffsets[i] = static_cast<uint64_t>(streams[i].tellp());
+			}
+			checkpointDone.store(request, std::memory_order_release);
+		}
+		if (!progressed) {
+			if (finishing)
+				break;
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+	}
+	for (size_t i = 0; i < uavCount; i++) {
+		flush(i);
+		streams[i].close();
+	}
+}
+
+void AsyncTextTrajectorySink::checkpoint(std::vector<uint64_t>& offsets) {
+	const size_t request = checkpointRequest.load(std::memory_order_relaxed) + 1;
+	checkpointRequest.store(request, std::memory_order_release);
+	while (checkpointDone.load(std::memory_order_acquire) != request)
+		std::this_thread::yield();
+	offsets.insert(offsets.end(), checkpointOffsets.begin(), checkpointOffsets.end());
+}
+
+void AsyncTextTrajectorySink::close() {
+	if (closed)
+		return;
+	closed = true;
+	closing.store(true, std::memory_order_release);
+	writer.join();
+}
@@ -0,0 +1,62 @@
+#ifndef ASYNC_TEXT_TRAJECTORY_SINK_H
+#define ASYNC_TEXT_TRAJECTORY_SINK_H
+
+#include "TrajectorySink.h"
+#include <atomic>
+#include <thread>
+#include <memory_resource>
+
+// Same "UAV<n>.txt" files as TextTrajectorySink (byte for byte), but off the tick thread:
+// record() only copies the raw sample into a preallocated per-UAV ring buffer, and a background
+// writer drains the rings, formats with std::to_chars and writes in large blocks.
+// each ring is single-producer/single-consumer, when one is full the producer waits for the writer.
+class AsyncTextTrajectorySink : public TrajectorySink {
+private:
+	size_t uavCount;
+	size_t ringCapacity; // power of two
+	std::pmr::vector<TrajectoryRecord> rings; // uavCount rings of ringCapacity records, back to back
+	std::vector<std::atomic<size_t>> heads; // written by the producer of each UAV
+	std::vector<std::atomic<size_t>> tails; // written by the writer thread
+	std::vector<size_t> cachedTails; // producer-side copy of tails, refreshed only when a ring looks full
+
+	std::vector<std::ofstream> streams;
+	std::vector<std::string> pending; // formatted text not yet handed to the stream, flushSize reserved each
+	size_t flushSize;                 // a UAV's text goes to its stream in blocks of up to this size
+	// checkpoint handshake: the tick thread bumps the request, the writer answers after writing out
+	// everything recorded before it and filling checkpointOffsets
+	std::atomic<size_t> checkpointRequest, checkpointDone;
+	std::vector<uint64_t> checkpointOffsets;
+	std::atomic<bool> closing;
+	bool closed;
+	std::thread writer;
+
+	void writerLoop();
+	bool drain(const size_t uavNum);
+	void flush(const size_t uavNum);
+
+	static size_t ringCapacityFor(const size_t uavCount, const size_t ringCapacity);
+	static size_t flushSizeFor(const size_t uavCount);
+
+public:
+	// the rings come from resource (see SimArena), the writer thread's buffers from the heap
+	AsyncTextTrajectorySink(const size_t uavCount, const std::string& directory, const size_t ringCapacity = 0,
+		const std::vector<uint64_t>* resumeOffsets = nullptr, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+	~AsyncTextTrajectorySink() override;
+
+	// what the constructor takes from its memory resource
+	static size_t memoryBytes(const size_t uavCount, const size_t ringCapacity = 0);
+
+	void record(const size_t uavNum, const double time, const double x, const double y, const double radianAngle) override;
+
+	// waits for the writer to catch up (the rings are normally near empty, it does not wait for the disk)
+	void checkpoint(std::vector<uint64_t>& offsets) override;
+
+	void close() override;
+
+	// formats a sample exactly like std::fixed << std::setprecision(2), returns the line length
+	// (out needs room for 4 numbers, at most 4 * 312 chars for huge doubles)
+	static const size_t maxLineLength = 4 * 320;
+	static size_t formatLine(char* out, const TrajectoryRecord& sample);
+};
+
+#endif
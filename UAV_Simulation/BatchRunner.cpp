@@ -0,0 +1,213 @@
+#include "BatchRunner.h"
+#include "Simulation.h"
+#include "SharedCommandSource.h"
+#include "Profiler.h"
+#include <chrono>
+#include <filesystem>
+#include <iterator>
+#include <thread>
+
+static std::string trimBlanks(const std::string& s) {
+	const size_t start = s.find_first_not_of(" \t\r");
+	const size_t end = s.find_last_not_of(" \t\r");
+	return (start == std::string::npos) ? "" : s.substr(start, end - start + 1);
+}
+
+std::vector<std::string> BatchRunner::expandValues(const std::string& list) {
+	std::vector<std::string> values;
+	std::istringstream items(list);
+	std::string item;
+	while (std::getline(items, item, ',')) {
+		item = trimBlanks(item);
+		if (item.empty()) {
+			throw std::runtime_error("Empty value in sweep list: " + list);
+		}
+		const size_t first = item.find(':'), second = item.find(':', first + 1);
+		if (first == std::string::npos) {
+			values.push_back(item);
+			continue;
+		}
+		double from, to, step;
+		std::istringstream a(item.substr(0, first)), b(item.substr(first + 1, second - first - 1)), c(item.substr(second + 1));
+		if (second == std::string::npos || !(a >> from) || !(b >> to) || !(c >> step) || step <= 0. || to < from) {
+			throw std::runtime_error("Invalid sweep range: " + item);
+		}
+		// the last value is included when it is on the grid (up to rounding)
+		const size_t count = static_cast<size_t>(floor((to - from) / step + 1e-9)) + 1;
+		for (size_t i = 0; i < count; i++) {
+			std::ostringstream value;
+			value << std::setprecision(12) << from + i * step;
+			values.push_back(value.str());
+		}
+	}
+	if (values.empty()) {
+		throw std::runtime_error("Empty sweep list");
+	}
+	return values;
+}
+
+BatchRunner::BatchRunner(const std::string& specFile)
+	: directory("sweep"), workers(0)
+{
+	std::ifstream spec(specFile);
+	if (!spec.is_open()) {
+		throw std::runtime_error("Failed to open " + specFile);
+	}
+	std::string configFile = "SimParams.ini", commandsFile = "SimCmds.txt";
+	std::vector<std::pair<std::string, std::vector<std::string>>> swept;
+	std::string line;
+	while (std::getline(spec, line)) {
+		line = trimBlanks(line);
+		if (line.empty() || line[0] == '#')
+			continue;
+		const size_t equalsPos = line.find('=');
+		if (equalsPos == std::string::npos)
+			continue;
+		const std::string key = trimBlanks(line.substr(0, equalsPos));
+		const std::string value = trimBlanks(line.substr(equalsPos + 1));
+		if (key == "Config") configFile = value;
+		else if (key == "Commands") commandsFile = value;
+		else if (key == "OutputDirectory") directory = value;
+		else if (key == "Workers") workers = static_cast<size_t>(std::stoul(value));
+		else swept.push_back({ key, expandValues(value) });
+	}
+	if (workers == 0)
+		workers = std::max(1u, std::thread::hardware_concurrency());
+#if UAV_PROFILE
+	// the profiler is one per process and every Simulation::run resets it
+	if (workers > 1)
+		std::cerr << "Warning: the sweep runs on 1 worker, the program was built with UAV_PROFILE" << '\n';
+	workers = 1;
+#endif
+
+	std::ifstream base(configFile);
+	if (!base.is_open()) {
+		throw std::runtime_error("Failed to open " + configFile);
+	}
+	const std::string baseText((std::istreambuf_iterator<char>(base)), std::istreambuf_iterator<char>());
+
+	size_t total = 1;
+	for (const auto& s : swept)
+		total *= s.second.size();
+	const size_t digits = std::to_string(total - 1).size();
+	// every combination, the first key varying slowest; the overrides go after the base file, so they win
+	for (size_t index = 0; index < total; index++) {
+		Scenario scenario;
+		std::string number = std::to_string(index);
+		scenario.name = "scenario" + std::string(digits - number.size(), '0') + number;
+		std::string text = baseText + "\n";
+		size_t rest = index;
+		for (size_t k = swept.size(); k-- > 0;) {
+			const std::string& value = swept[k].second[rest % swept[k].second.size()];
+			rest /= swept[k].second.size();
+			text += swept[k].first + " = " + value + "\n";
+			scenario.values = swept[k].first + "=" + value + (scenario.values.empty() ? "" : " ") + scenario.values;
+		}
+		std::istringstream configText(text);
+		try {
+			scenario.config = Simulation::parseConfig(configText);
+		}
+		catch (const std::exception& e) {
+			throw std::runtime_error(scenario.name + " (" + scenario.values + "): " + e.what());
+		}
+		// every scenario reads the shared commands and writes to its own directory
+		scenario.config.setCommandPipe("");
+		scenario.config.setCommandQueue(0);
+		scenario.config.setResumeFrom("");
+		scenario.config.setOutputDirectory((std::filesystem::path(directory) / scenario.name).string());
+		scenario.seconds = 0.;
+		scenarios.push_back(std::move(scenario));
+	}
+	// loaded for the largest fleet of the sweep, smaller ones are checked against the largest UAV number
+	size_t uavCount = 0;
+	for (const Scenario& scenario : scenarios)
+		uavCount = std::max(uavCount, scenario.config.getTotalUavs());
+	commands = std::make_shared<const std::vector<Command>>(Simulation::loadCommandsVectorFromFileSorted(commandsFile, uavCount,
+		scenarios.empty() ? std::string() : scenarios.front().config.getCommandCache()));
+	size_t uavBound = 0;
+	for (const Command& command : *commands)
+		uavBound = std::max(uavBound, command.getUavNum() + 1);
+	for (const Scenario& scenario : scenarios) {
+		if (scenario.config.getTotalUavs() < uavBound) {
+			throw std::runtime_error(scenario.name + " (" + scenario.values + "): " + commandsFile + " has commands for UAV " +
+				std::to_string(uavBound - 1) + ", but N_uav = " + std::to_string(scenario.config.getTotalUavs()));
+		}
+	}
+
+	workers = std::min(workers, scenarios.size());
+	for (size_t w = 0; w < workers; w++)
+		queues.push_back(std::make_unique<WorkQueue>());
+	for (size_t i = 0; i < scenarios.size(); i++)
+		queues[i % workers]->scenarios.push_back(i);
+}
+
+bool BatchRunner::nextScenario(const size_t worker, size_t& scenario) {
+	{
+		WorkQueue& own = *queues[worker];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.scenarios.empty()) {
+			scenario = own.scenarios.back();
+			own.scenarios.pop_back();
+			return true;
+		}
+	}
+	// nothing is ever added, so one pass over the others finds the remaining work
+	for (size_t i = 1; i < queues.size(); i++) {
+		WorkQueue& victim = *queues[(worker + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.scenarios.empty()) {
+			scenario = victim.scenarios.front();
+			victim.scenarios.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void BatchRunner::runScenario(Scenario& scenario) {
+	const auto start = std::chrono::steady_clock::now();
+	try {
+		Simulation sim(scenario.config, std::make_unique<SharedCommandSource>(commands));
+		sim.run();
+	}
+	catch (const std::exception& e) {
+		scenario.error = e.what();
+	}
+	scenario.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void BatchRunner::workerLoop(const size_t worker) {
+	size_t scenario;
+	while (nextScenario(worker, scenario))
+		runScenario(scenarios[scenario]);
+}
+
+size_t BatchRunner::run() {
+	const auto start = std::chrono::steady_clock::now();
+	std::filesystem::create_directories(directory);
+	std::vector<std::thread> threads;
+	for (size_t w = 1; w < workers; w++)
+		threads.emplace_back(&BatchRunner::workerLoop, this, w);
+	workerLoop(0);
+	for (auto& t : threads)
+		t.join();
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	const std::string summaryFile = (std::filesystem::path(directory) / "scenarios.txt").string();
+	std::ofstream summary(summaryFile);
+	if (!summary.is_open()) {
+		throw std::runtime_error("Unable to open file: " + summaryFile);
+	}
+	size_t failed = 0;
+	for (const auto& s : scenarios) {
+		summary << s.name << ' ' << s.values << ' ' << std::fixed << std::setprecision(3) << s.seconds << "s "
+			<< (s.error.empty() ? "ok" : "failed: " + s.error) << '\n';
+		if (!s.error.empty()) {
+			std::cerr << "Error: " << s.name << " (" << s.values << "): " << s.error << '\n';
+			failed++;
+		}
+	}
+	std::cout << "Sweep: " << scenarios.size() << " scenarios on " << workers << " workers in " << seconds << " s, "
+		<< failed << " failed (see " << summaryFile << ")" << '\n';
+	return failed;
+}
@@ -0,0 +1,62 @@
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include "project_headers.h"
+#include "SimConfig.h"
+#include "Command.h"
+#include <deque>
+#include <memory>
+#include <mutex>
+
+// Parameter sweep over many SimParams.ini variations ("UAV_Simulation --sweep <spec>").
+// the spec uses the SimParams.ini syntax:
+//   Config = SimParams.ini      base configuration of every scenario (default)
+//   Commands = SimCmds.txt      commands file of every scenario (default)
+//   OutputDirectory = sweep     each scenario writes to <OutputDirectory>/scenario<n>/ (default "sweep")
+//   Workers = 0                 scenarios run at the same time, 0 = one per core (default)
+//   R = 50, 100, 150            any other key is a SimParams.ini key with a list of values,
+//   V0 = 40:80:10               or first:last:step ranges - the sweep is every combination
+// the commands file is parsed and sorted once and shared read-only (SharedCommandSource), and the
+// scenarios run as independent Simulations on a work-stealing pool: scenarios are dealt round-robin
+// to per-worker deques, a worker takes from the back of its own and, when that is empty, steals from
+// the front of the others - so a few long scenarios (small Dt, long TimeLim) do not leave cores idle.
+// a UAV_PROFILE build runs the scenarios one at a time whatever Workers says: the profiler (Profiler.h)
+// is shared by the whole process, so only one Simulation may run at once, and each scenario reports its own.
+// <OutputDirectory>/scenarios.txt lists every scenario with its values, run time and result.
+class BatchRunner {
+private:
+	struct Scenario {
+		std::string name;
+		std::string values; // "key=value ..." of the swept keys
+		SimConfig config;
+		double seconds;
+		std::string error;  // empty when the run succeeded
+	};
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<size_t> scenarios;
+	};
+
+	std::string directory;
+	size_t workers;
+	std::shared_ptr<const std::vector<Command>> commands;
+	std::vector<Scenario> scenarios;
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+
+	bool nextScenario(const size_t worker, size_t& scenario);
+	void workerLoop(const size_t worker);
+	void runScenario(Scenario& scenario);
+
+	// "a, b, first:last:step" -> every value
+	static std::vector<std::string> expandValues(const std::string& list);
+
+public:
+	explicit BatchRunner(const std::string& specFile);
+
+	size_t getScenarioCount() const { return scenarios.size(); }
+
+	// runs the whole sweep, returns how many scenarios failed
+	size_t run();
+};
+
+#endif
@@ -0,0 +1,140 @@
+#include "BinaryTrajectorySink.h"
+#include "Profiler.h"
+#include <cstring>
+
+static const size_t chunkBudget = 1 << 21; // default total buffered samples over all UAVs
+
+BinaryTrajectorySink::BinaryTrajectorySink(const std::string& fileName, const SimConfig& config, const TrajectoryEncoding encoding, const size_t chunkCapacity)
+	: header(), encoding(encoding),
+	chunkCapacity((chunkCapacity != 0) ? chunkCapacity : std::clamp<size_t>(chunkBudget / std::max<size_t>(config.getTotalUavs(), 1), 64, 4096)),
+	buffers(config.getTotalUavs()), chunks(config.getTotalUavs()), written(config.getTotalUavs(), 0),
+	previous(config.getTotalUavs()), markers(config.getTotalUavs()),
+	fileEnd(sizeof(TrajectoryFileHeader)), closed(false)
+{
+	file.open(fileName.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		throw std::runtime_error("Unable to open file: " + fileName);
+	}
+	std::memcpy(header.magic, trajectoryMagic, sizeof(header.magic));
+	header.version = trajectoryVersion;
+	header.encoding = encoding;
+	header.x0 = config.getX();
+	header.y0 = config.getY();
+	header.z0 = config.getZ();
+	header.v0 = config.getV0();
+	header.r0 = config.getR0();
+	header.initialAngleRadians = config.getAngleRad();
+	header.timeLimit = config.getTimeLimit();
+	header.dt = config.getDt();
+	header.uavCount = config.getTotalUavs();
+	header.chunkCapacity = this->chunkCapacity;
+	// placeholder header, indexOffset stays 0 until close() so readers can tell an unfinished file
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	for (auto& b : buffers) {
+		b.reserve(this->chunkCapacity);
+	}
+}
+
+BinaryTrajectorySink::~BinaryTrajectorySink() {
+	close();
+}
+
+size_t BinaryTrajectorySink::encodeColumn(const TrajectoryEncoding encoding, const bool timeColumn,
+	const double* values, const size_t stride, const size_t count, unsigned char* out) {
+	const size_t bytes = trajectoryColumnBytes(encoding, timeColumn, count);
+	std::memset(out, 0, bytes);
+	if (encoding == ENCODE_F64 || (encoding == ENCODE_F32 && timeColumn)) {
+		for (size_t k = 0; k < count; k++) {
+			std::memcpy(out + k * sizeof(double), values + k * stride, sizeof(double));
+		}
+	}
+	else if (encoding == ENCODE_F32) {
+		for (size_t k = 0; k < count; k++) {
+			const float v = static_cast<float>(values[k * stride]);
+			std::memcpy(out + k * sizeof(float), &v, sizeof(float));
+		}
+	}
+	else {
+		// deltas are taken from the value the reader will reconstruct, so the float rounding does not accumulate
+		double previous = values[0];
+		std::memcpy(out, &previous, sizeof(double));
+		for (size_t k = 1; k < count; k++) {
+			const float delta = static_cast<float>(values[k * stride] - previous);
+			previous += static_cast<double>(delta);
+			std::memcpy(out + sizeof(double) + (k - 1) * sizeof(float), &delta, sizeof(float));
+		}
+	}
+	return bytes;
+}
+
+void BinaryTrajectorySink::writeChunk(const size_t uavNum) {
+	std::vector<TrajectoryRecord>& samples = buffers[uavNum];
+	const size_t count = samples.size();
+	if (count == 0)
+		return;
+	const size_t stride = sizeof(TrajectoryRecord) / sizeof(double);
+	const uint64_t timeBytes = trajectoryColumnBytes(encoding, true, count);
+	const uint64_t valueBytes = trajectoryColumnBytes(encoding, false, count);
+	std::vector<unsigned char> block(timeBytes + 3 * valueBytes);
+	unsigned char* out = block.data();
+	out += encodeColumn(encoding, true, &samples[0].time, stride, count, out);
+	out += encodeColumn(encoding, false, &samples[0].x, stride, count, out);
+	out += encodeColumn(encoding, false, &samples[0].y, stride, count, out);
+	encodeColumn(encoding, false, &samples[0].radianAngle, stride, count, out);
+
+	TrajectoryChunkEntry entry = { 0, written[uavNum], count, samples.front().time, samples.back().time };
+	{
+		std::lock_guard<std::mutex> lock(fileMutex);
+		entry.offset = fileEnd;
+		file.write(reinterpret_cast<const char*>(block.data()), block.size());
+		fileEnd += block.size();
+		header.chunkCount++;
+		header.sampleCount += count;
+	}
+	chunks[uavNum].push_back(entry);
+	written[uavNum] += count;
+	samples.clear();
+}
+
+void BinaryTrajectorySink::record(const size_t uavNum, const double time, const double x, const double y, const double radianAngle) {
+	const uint64_t sample = written[uavNum] + buffers[uavNum].size();
+	if (sample > 0) {
+		const TrajectoryPhase phase = trajectoryPhaseOf(previous[uavNum].radianAngle, radianAngle);
+		std::vector<TrajectoryMarker>& uavMarkers = markers[uavNum];
+		if (uavMarkers.empty() || uavMarkers.back().phase != phase)
+			uavMarkers.push_back({ previous[uavNum].time, sample - 1, phase, 0 });
+	}
+	previous[uavNum] = { time, x, y, radianAngle };
+	buffers[uavNum].push_back({ time, x, y, radianAngle });
+	if (buffers[uavNum].size() == chunkCapacity)
+		writeChunk(uavNum);
+}
+
+void BinaryTrajectorySink::close() {
+	if (closed)
+		return;
+	closed = true;
+	for (size_t i = 0; i < buffers.size(); i++) {
+		writeChunk(i);
+	}
+	// index: per UAV entries, then all chunk entries and all markers grouped by UAV
+	header.indexOffset = fileEnd;
+	uint64_t firstChunk = 0;
+	for (size_t i = 0; i < chunks.size(); i++) {
+		const TrajectoryUavEntry entry = { firstChunk, chunks[i].size(), written[i], header.markerCount, markers[i].size() };
+		file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+		firstChunk += chunks[i].size();
+		header.markerCount += markers[i].size();
+	}
+	for (const auto& uavChunks : chunks) {
+		file.write(reinterpret_cast<const char*>(uavChunks.data()), uavChunks.size() * sizeof(TrajectoryChunkEntry));
+	}
+	for (const auto& uavMarkers : markers) {
+		file.write(reinterpret_cast<const char*>(uavMarkers.data()), uavMarkers.size() * sizeof(TrajectoryMarker));
+	}
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	PROFILE_COUNT(COUNT_BYTES, fileEnd + chunks.size() * sizeof(TrajectoryUavEntry) + header.chunkCount * sizeof(TrajectoryChunkEntry) +
+		header.markerCount * sizeof(TrajectoryMarker));
+	file.close();
+}
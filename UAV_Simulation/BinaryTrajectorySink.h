@@ -0,0 +1,43 @@
+#ifndef BINARY_TRAJECTORY_SINK_H
+#define BINARY_TRAJECTORY_SINK_H
+
+#include "TrajectorySink.h"
+#include "TrajectoryFile.h"
+#include "SimConfig.h"
+#include <mutex>
+
+// Writes every UAV's samples into one columnar binary file (layout in TrajectoryFile.h).
+// samples collect in a per-UAV buffer of chunkCapacity records, a full buffer is encoded and
+// appended as one chunk. the index and the final header are written by close().
+// the phase markers come from comparing each sample's azimuth with the one before.
+class BinaryTrajectorySink : public TrajectorySink {
+private:
+	std::ofstream file;
+	TrajectoryFileHeader header;
+	TrajectoryEncoding encoding;
+	size_t chunkCapacity;
+	std::vector<std::vector<TrajectoryRecord>> buffers;
+	std::vector<std::vector<TrajectoryChunkEntry>> chunks; // per UAV, in time order
+	std::vector<uint64_t> written; // samples already in chunks, per UAV
+	std::vector<TrajectoryRecord> previous; // last sample, per UAV
+	std::vector<std::vector<TrajectoryMarker>> markers; // per UAV, in time order
+	uint64_t fileEnd;
+	std::mutex fileMutex; // chunks of different UAVs may be written by different threads
+	bool closed;
+
+	void writeChunk(const size_t uavNum);
+
+public:
+	BinaryTrajectorySink(const std::string& fileName, const SimConfig& config, const TrajectoryEncoding encoding, const size_t chunkCapacity = 0);
+	~BinaryTrajectorySink() override;
+
+	void record(const size_t uavNum, const double time, const double x, const double y, const double radianAngle) override;
+
+	void close() override;
+
+	// encodes count values into out (which must hold trajectoryColumnBytes), returns the bytes used
+	static size_t encodeColumn(const TrajectoryEncoding encoding, const bool timeColumn,
+		const double* values, const size_t stride, const size_t count, unsigned char* out);
+};
+
+#endif
@@ -0,0 +1,92 @@
+#include "Checkpoint.h"
+#include <cstdio>
+#include <iterator>
+
+Checkpointer::Checkpointer(const SimConfig& config)
+	: interval(config.getCheckpointInterval()), nextTime(config.getCheckpointInterval()), fileName(config.outputPath(config.getCheckpointFile())),
+	hasPending(false), stopping(false)
+{
+	if (interval > 0.)
+		writer = std::thread(&Checkpointer::writerLoop, this);
+}
+
+Checkpointer::~Checkpointer() {
+	if (!writer.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_one();
+	writer.join(); // the last snapshot is still written
+	if (!error.empty())
+		std::cerr << "Warning: " << error << '\n';
+}
+
+void Checkpointer::writerLoop() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		wake.wait(lock, [this] { return hasPending || stopping; });
+		if (!hasPending)
+			return;
+		std::string snapshot = std::move(pending);
+		hasPending = false;
+		lock.unlock();
+		const std::string temporary = fileName + ".tmp";
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		file.write(snapshot.data(), snapshot.size());
+		file.close();
+		// std::rename does not replace an existing file everywhere, remove it first
+		const bool written = !file.fail() && (std::remove(fileName.c_str()), std::rename(temporary.c_str(), fileName.c_str()) == 0);
+		lock.lock();
+		if (!written)
+			error = "Unable to write checkpoint: " + fileName;
+	}
+}
+
+void Checkpointer::submit(std::string snapshot, const double currentTime) {
+	while (nextTime <= currentTime)
+		nextTime += interval;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!error.empty()) {
+			throw std::runtime_error(error);
+		}
+		pending = std::move(snapshot);
+		hasPending = true;
+	}
+	wake.notify_one();
+}
+
+void Checkpointer::resumedAt(const double currentTime) {
+	if (interval <= 0.)
+		return;
+	nextTime = interval;
+	while (nextTime <= currentTime)
+		nextTime += interval;
+}
+
+std::string Checkpointer::load(const std::string& fileName) {
+	std::ifstream file(fileName, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("Unable to open file: " + fileName);
+	}
+	return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void Checkpointer::reopenOutput(std::ofstream& stream, const std::string& fileName, const uint64_t size) {
+	std::error_code error;
+	const uintmax_t current = std::filesystem::file_size(fileName, error);
+	if (error || current < size) {
+		throw std::runtime_error("Output file " + fileName + " is shorter than at the checkpoint");
+	}
+	std::filesystem::resize_file(fileName, size, error);
+	if (error) {
+		throw std::runtime_error("Unable to truncate file: " + fileName);
+	}
+	// ate as well, so tellp reports the file size before the first write
+	stream.open(fileName.c_str(), std::ios::out | std::ios::app | std::ios::ate);
+	if (!stream.is_open()) {
+		throw std::runtime_error("Unable to open file: " + fileName);
+	}
+}
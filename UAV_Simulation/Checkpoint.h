@@ -0,0 +1,132 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "project_headers.h"
+#include "SimConfig.h"
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+// Checkpoint file of a run ("CheckpointInterval" / "CheckpointFile" / "ResumeFrom" keys), in this order:
+//   CheckpointHeader
+//   text output file sizes (one per UAV, none without text output)
+//   ConflictDetector: events file size and open conflicts (if the separation check is on)
+//   CommandSource state (the commands not applied yet)
+//   engine state: every UAV's x, y, radianAngle, dest, state and clockwise (plus the heading vector
+//   for Engine = heading)
+//   OutputDecimator state
+// everything is stored as raw little-endian / native values - a checkpoint is meant for the machine
+// (and build) that wrote it. the run resumes at the tick the checkpoint was taken, before its commands.
+static const char checkpointMagic[8] = { 'U', 'A', 'V', 'C', 'K', 'P', '0', '1' };
+static const uint32_t checkpointVersion = 1;
+
+struct CheckpointHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t engine;
+	uint64_t uavCount;
+	double dt, timeLimit;
+	uint64_t tick;
+	double currentTime;
+};
+
+// snapshot being written, in memory
+class CheckpointBuffer {
+private:
+	std::string data;
+public:
+	template <typename T>
+	void put(const T& value) {
+		static_assert(std::is_trivially_copyable<T>::value, "checkpoints store raw values");
+		data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+	template <typename T, typename Allocator>
+	void putVector(const std::vector<T, Allocator>& values) {
+		static_assert(std::is_trivially_copyable<T>::value, "checkpoints store raw values");
+		put<uint64_t>(values.size());
+		data.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+	}
+	std::string take() { return std::move(data); }
+};
+
+// checkpoint being read back, throws when it ends early
+class CheckpointReader {
+private:
+	std::string data;
+	size_t position;
+
+	const char* next(const size_t bytes) {
+		if (data.size() - position < bytes) {
+			throw std::runtime_error("Truncated checkpoint");
+		}
+		const char* p = data.data() + position;
+		position += bytes;
+		return p;
+	}
+public:
+	explicit CheckpointReader(std::string data) : data(std::move(data)), position(0) {}
+
+	template <typename T>
+	T get() {
+		T value;
+		std::memcpy(&value, next(sizeof(T)), sizeof(T));
+		return value;
+	}
+	template <typename T>
+	std::vector<T> getVector() {
+		const uint64_t count = get<uint64_t>();
+		if (count > (data.size() - position) / sizeof(T)) {
+			throw std::runtime_error("Truncated checkpoint");
+		}
+		std::vector<T> values(static_cast<size_t>(count));
+		std::memcpy(values.data(), next(values.size() * sizeof(T)), values.size() * sizeof(T));
+		return values;
+	}
+};
+
+// Decides when a checkpoint is due and writes the snapshots on a background thread, so the tick loop
+// only pays for copying the state into memory. the file is written next to its final name and renamed
+// over it, a crash while writing leaves the previous checkpoint intact. when snapshots come faster
+// than the disk takes them, only the newest waiting one is written.
+class Checkpointer {
+private:
+	double interval;
+	double nextTime;
+	std::string fileName;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::string pending;
+	bool hasPending, stopping;
+	std::string error; // from the writer thread, rethrown by the next submit
+	std::thread writer;
+
+	void writerLoop();
+
+public:
+	explicit Checkpointer(const SimConfig& config);
+	~Checkpointer();
+
+	Checkpointer(const Checkpointer&) = delete;
+	Checkpointer& operator=(const Checkpointer&) = delete;
+
+	// true on the first tick at or after every multiple of the interval (never with interval 0)
+	bool due(const double currentTime) const { return interval > 0. && currentTime >= nextTime; }
+
+	// hand a snapshot taken at currentTime to the writer thread
+	void submit(std::string snapshot, const double currentTime);
+
+	// a resumed run takes its next checkpoint one interval after the one it resumed from
+	void resumedAt(const double currentTime);
+
+	static std::string load(const std::string& fileName);
+
+	// opens an output file of the run being resumed for appending, cut back to its size at the checkpoint
+	static void reopenOutput(std::ofstream& stream, const std::string& fileName, const uint64_t size);
+};
+
+#endif
@@ -1,9 +1,9 @@
 #include "Command.h"
 
 // compare commands by time, from high to low
-bool Command::operator<(const Command& other) const
+bool Command::later(const Command& a, const Command& b)
 {
-	return this->getTime() > other.getTime();
+	return a.getTime() > b.getTime();
 }
 
 
@@ -16,7 +16,8 @@ public:
 
 	}
 
-	bool operator<(const Command& other) const;
+	// true when a is due after b - sorting with it puts the earliest command at the back of the vector
+	static bool later(const Command& a, const Command& b);
 
 
 	// avoid duplicate commands
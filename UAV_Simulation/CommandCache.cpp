@@ -0,0 +1,65 @@
+#include "CommandCache.h"
+#include "MappedFile.h"
+#include <cstring>
+#include <filesystem>
+
+void CommandCache::stamp(const std::string& file, uint64_t& size, int64_t& modified) {
+	std::error_code error;
+	const uintmax_t bytes = std::filesystem::file_size(file, error);
+	const auto written = std::filesystem::last_write_time(file, error);
+	if (error) {
+		throw std::runtime_error("Unable to open file: " + file);
+	}
+	size = static_cast<uint64_t>(bytes);
+	modified = static_cast<int64_t>(written.time_since_epoch().count());
+}
+
+bool CommandCache::read(const std::string& cacheFile, const std::string& sourceFile, const size_t uavCount,
+	std::vector<Command>& commands) {
+	std::error_code missing;
+	if (!std::filesystem::exists(cacheFile, missing))
+		return false;
+	uint64_t sourceSize;
+	int64_t sourceModified;
+	stamp(sourceFile, sourceSize, sourceModified);
+
+	const MappedFile mapped(cacheFile);
+	CommandCacheHeader header;
+	if (mapped.size() < sizeof(header))
+		return false;
+	std::memcpy(&header, mapped.begin(), sizeof(header));
+	if (std::memcmp(header.magic, commandCacheMagic, sizeof(header.magic)) != 0 || header.version != commandCacheVersion ||
+		header.commandSize != sizeof(Command) || mapped.size() != sizeof(header) + header.count * sizeof(Command))
+		return false;
+	if (header.sourceSize != sourceSize || header.sourceModified != sourceModified)
+		return false; // stale
+	if (header.uavBound > uavCount)
+		return false; // parsing reports the offending line
+	commands.resize(static_cast<size_t>(header.count));
+	if (header.count > 0)
+		std::memcpy(commands.data(), mapped.begin() + sizeof(header), commands.size() * sizeof(Command));
+	return true;
+}
+
+void CommandCache::write(const std::string& cacheFile, const uint64_t sourceSize, const int64_t sourceModified,
+	const std::vector<Command>& commands) {
+	CommandCacheHeader header = {};
+	std::memcpy(header.magic, commandCacheMagic, sizeof(header.magic));
+	header.version = commandCacheVersion;
+	header.commandSize = sizeof(Command);
+	header.sourceSize = sourceSize;
+	header.sourceModified = sourceModified;
+	header.count = commands.size();
+	for (const Command& command : commands)
+		header.uavBound = std::max<uint64_t>(header.uavBound, command.getUavNum() + 1);
+
+	const std::string temporary = cacheFile + ".tmp";
+	std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(commands.data()), commands.size() * sizeof(Command));
+	file.close();
+	// std::rename does not replace an existing file everywhere, remove it first
+	if (file.fail() || (std::remove(cacheFile.c_str()), std::rename(temporary.c_str(), cacheFile.c_str()) != 0)) {
+		throw std::runtime_error("Unable to write command cache: " + cacheFile);
+	}
+}
@@ -0,0 +1,50 @@
+#ifndef COMMAND_CACHE_H
+#define COMMAND_CACHE_H
+
+#include "project_headers.h"
+#include "Command.h"
+#include <cstdint>
+#include <type_traits>
+
+// Binary cache of a parsed and sorted commands file (CommandCache = <file>), so later eager runs over
+// the same commands skip parsing and sorting: the cache is memory-mapped and its records are taken as
+// they are. (native byte order and Command layout - the cache belongs to the build that wrote it)
+//
+//   CommandCacheHeader
+//   Command[count]     - in VectorCommandSource order (latest first)
+//
+// the header records the size and modification time of the text file the cache was made from, a cache
+// that does not match the file any more is ignored (and rewritten by the run that parsed the file).
+static const char commandCacheMagic[8] = { 'U', 'A', 'V', 'C', 'M', 'D', '0', '1' };
+static const uint32_t commandCacheVersion = 1;
+
+struct CommandCacheHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t commandSize;    // sizeof(Command) of the writer
+	uint64_t sourceSize;     // of the commands file
+	int64_t sourceModified;  // last write time of the commands file, in file clock ticks
+	uint64_t count;
+	uint64_t uavBound;       // 1 + the largest UAV number in the commands (0 without commands)
+};
+
+static_assert(sizeof(CommandCacheHeader) == 48, "unexpected padding in CommandCacheHeader");
+static_assert(std::is_trivially_copyable<Command>::value, "the cache stores Command as raw bytes");
+
+class CommandCache {
+public:
+	// the cached commands, if cacheFile was written for the current version of sourceFile and every
+	// command fits a fleet of uavCount UAVs - false (commands untouched) when the file has to be parsed
+	static bool read(const std::string& cacheFile, const std::string& sourceFile, const size_t uavCount,
+		std::vector<Command>& commands);
+
+	// cache sorted commands parsed from sourceFile, as it was when sourceSize / sourceModified were taken
+	// (written to a temporary file and renamed, so a reader never sees half a cache)
+	static void write(const std::string& cacheFile, const uint64_t sourceSize, const int64_t sourceModified,
+		const std::vector<Command>& commands);
+
+	// the size and modification time of a file as they go into the header
+	static void stamp(const std::string& file, uint64_t& size, int64_t& modified);
+};
+
+#endif
@@ -0,0 +1,98 @@
+#include "CommandPipe.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+// the pipe is non-blocking (PIPE_NOWAIT), so connecting and reading are polled
+CommandPipe::CommandPipe(const std::string& name)
+	: name((name.rfind("\\\\.\\pipe\\", 0) == 0) ? name : "\\\\.\\pipe\\" + name), handle(INVALID_HANDLE_VALUE), connected(false)
+{
+	handle = CreateNamedPipeA(this->name.c_str(), PIPE_ACCESS_INBOUND, PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_NOWAIT,
+		1, 0, 1 << 16, 0, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Unable to create pipe: " + this->name);
+	}
+}
+
+void CommandPipe::release() {
+	if (handle != INVALID_HANDLE_VALUE) {
+		if (connected)
+			DisconnectNamedPipe(handle);
+		CloseHandle(handle);
+	}
+	handle = INVALID_HANDLE_VALUE;
+	connected = false;
+}
+
+size_t CommandPipe::read(char* buffer, const size_t size, const int timeoutMs) {
+	if (!connected) {
+		connected = ConnectNamedPipe(handle, nullptr) || GetLastError() == ERROR_PIPE_CONNECTED;
+		if (!connected) {
+			Sleep(timeoutMs);
+			return 0;
+		}
+	}
+	DWORD bytes = 0;
+	if (ReadFile(handle, buffer, static_cast<DWORD>(size), &bytes, nullptr) && bytes > 0)
+		return bytes;
+	const DWORD error = GetLastError();
+	if (error == ERROR_BROKEN_PIPE || error == ERROR_PIPE_NOT_CONNECTED) {
+		// the writer went away, wait for the next one
+		DisconnectNamedPipe(handle);
+		connected = false;
+	}
+	Sleep(1);
+	return 0;
+}
+
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+CommandPipe::CommandPipe(const std::string& name)
+	: name(name), fd(-1), keepAliveFd(-1), created(false)
+{
+	if (mkfifo(name.c_str(), 0600) == 0)
+		created = true;
+	else if (errno != EEXIST) {
+		throw std::runtime_error("Unable to create pipe: " + name);
+	}
+	// non-blocking, so opening does not wait for the first writer
+	fd = ::open(name.c_str(), O_RDONLY | O_NONBLOCK);
+	if (fd >= 0)
+		keepAliveFd = ::open(name.c_str(), O_WRONLY | O_NONBLOCK);
+	if (fd < 0 || keepAliveFd < 0) {
+		release();
+		throw std::runtime_error("Unable to open pipe: " + name);
+	}
+}
+
+void CommandPipe::release() {
+	if (keepAliveFd >= 0)
+		::close(keepAliveFd);
+	if (fd >= 0)
+		::close(fd);
+	if (created)
+		unlink(name.c_str());
+	fd = keepAliveFd = -1;
+	created = false;
+}
+
+size_t CommandPipe::read(char* buffer, const size_t size, const int timeoutMs) {
+	pollfd request = { fd, POLLIN, 0 };
+	if (poll(&request, 1, timeoutMs) <= 0)
+		return 0;
+	const ssize_t bytes = ::read(fd, buffer, size);
+	return (bytes > 0) ? static_cast<size_t>(bytes) : 0;
+}
+
+#endif
+
+CommandPipe::~CommandPipe() {
+	release();
+}
@@ -0,0 +1,36 @@
+#ifndef COMMAND_PIPE_H
+#define COMMAND_PIPE_H
+
+#include "project_headers.h"
+
+// Read end of a local named pipe that other processes write command lines into - a FIFO on POSIX
+// (created if it does not exist, removed again if it was created here), "\\.\pipe\<name>" on Windows.
+// writers may connect and disconnect any number of times while the pipe is open.
+class CommandPipe {
+private:
+	std::string name;
+#ifdef _WIN32
+	void* handle;
+	bool connected;
+#else
+	int fd;
+	int keepAliveFd; // our own write end, so the FIFO does not report end-of-file between writers
+	bool created;
+#endif
+
+	void release();
+
+public:
+	explicit CommandPipe(const std::string& name);
+	~CommandPipe();
+
+	CommandPipe(const CommandPipe&) = delete;
+	CommandPipe& operator=(const CommandPipe&) = delete;
+
+	const std::string& getName() const { return name; }
+
+	// waits up to timeoutMs for input, returns the bytes read into buffer (0 if nothing arrived)
+	size_t read(char* buffer, const size_t size, const int timeoutMs);
+};
+
+#endif
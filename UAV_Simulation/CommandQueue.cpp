@@ -0,0 +1,56 @@
+#include "CommandQueue.h"
+
+static size_t powerOfTwoAtLeast(const size_t n) {
+	size_t p = 2;
+	while (p < n)
+		p <<= 1;
+	return p;
+}
+
+CommandQueue::CommandQueue(const size_t capacity)
+	: mask(powerOfTwoAtLeast(capacity) - 1),
+	cells(new Cell[mask + 1]), tail(0), head(0)
+{
+	// cell i is free for the producer of position i
+	for (size_t i = 0; i <= mask; i++)
+		cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool CommandQueue::push(const Entry& entry) {
+	uint64_t position = tail.load(std::memory_order_relaxed);
+	for (;;) {
+		Cell& cell = cells[position & mask];
+		const uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+		if (sequence == position) {
+			if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+				cell.entry = entry;
+				cell.sequence.store(position + 1, std::memory_order_release);
+				return true;
+			}
+		}
+		else if (sequence < position)
+			return false; // the cell still holds the entry of the previous round: full
+		else
+			position = tail.load(std::memory_order_relaxed); // another producer took it
+	}
+}
+
+bool CommandQueue::tryPop(Entry& entry) {
+	Cell& cell = cells[head & mask];
+	if (cell.sequence.load(std::memory_order_acquire) != head + 1)
+		return false;
+	entry = cell.entry;
+	// free for the producer one round later
+	cell.sequence.store(head + mask + 1, std::memory_order_release);
+	head++;
+	return true;
+}
+
+bool CommandQueue::Producer::tryPush(const Command& command) {
+	if (!queue->push({ command, id, sequence })) {
+		rejected++;
+		return false;
+	}
+	sequence++;
+	return true;
+}
@@ -0,0 +1,74 @@
+#ifndef COMMAND_QUEUE_H
+#define COMMAND_QUEUE_H
+
+#include "project_headers.h"
+#include "Command.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Bounded lock-free queue of commands pushed by any number of threads while a run goes on ("CommandQueue"
+// key, see QueueCommandSource), taken out by the tick thread only. a ring of cells that each carry a
+// sequence number: a producer claims a slot with one compare-exchange on the tail, fills it and publishes it
+// through the cell's sequence, so producers never wait for each other or for the tick thread.
+// a full ring is reported to the producer (tryPush returns false) - it may retry, drop or slow down,
+// the tick thread is never held up by it.
+class CommandQueue {
+public:
+	// a queued command and where it came from, so same-time commands have a deterministic order
+	struct Entry {
+		Command command;
+		uint32_t producer;
+		uint64_t sequence; // counted per producer
+	};
+
+	// one producing thread's handle. its id is chosen by the caller (not by arrival), and orders its
+	// commands against other producers' commands with the same time
+	class Producer {
+	private:
+		CommandQueue* queue;
+		uint32_t id;
+		uint64_t sequence;
+		uint64_t rejected;
+
+	public:
+		Producer(CommandQueue& queue, const uint32_t id) : queue(&queue), id(id), sequence(0), rejected(0) {}
+
+		// false if the queue is full, the command is not queued then
+		bool tryPush(const Command& command);
+
+		uint32_t getId() const { return id; }
+		uint64_t getPushed() const { return sequence; }
+		uint64_t getRejected() const { return rejected; }
+	};
+
+private:
+	struct Cell {
+		std::atomic<uint64_t> sequence;
+		Entry entry;
+	};
+
+	const size_t mask;
+	std::unique_ptr<Cell[]> cells;
+	// producers and the consumer on separate cache lines
+	alignas(64) std::atomic<uint64_t> tail;
+	alignas(64) uint64_t head;
+
+	bool push(const Entry& entry);
+
+public:
+	// capacity is rounded up to a power of two
+	explicit CommandQueue(const size_t capacity);
+
+	CommandQueue(const CommandQueue&) = delete;
+	CommandQueue& operator=(const CommandQueue&) = delete;
+
+	size_t capacity() const { return mask + 1; }
+
+	Producer producer(const uint32_t id) { return Producer(*this, id); }
+
+	// tick thread only: the oldest published entry, false if there is none
+	bool tryPop(Entry& entry);
+};
+
+#endif
@@ -0,0 +1,36 @@
+#include "CommandScheduler.h"
+
+CommandScheduler::CommandScheduler(CommandSource& source, const size_t uavCount, std::pmr::memory_resource* resource)
+	: source(source), slot(uavCount, noSlot, resource), bucket(resource)
+{
+	bucket.reserve(uavCount);
+}
+
+size_t CommandScheduler::memoryBytes(const size_t uavCount) {
+	return uavCount * (sizeof(size_t) + sizeof(Command));
+}
+
+const std::pmr::vector<Command>& CommandScheduler::collect(const double currentTime) {
+	// forget the previous tick, touching only the UAVs it used
+	for (const auto& c : bucket)
+		slot[c.getUavNum()] = noSlot;
+	bucket.clear();
+
+	Command command;
+	while (source.pollDue(currentTime, command)) {
+		const size_t uavNum = command.getUavNum();
+		if (uavNum >= slot.size()) {
+			throw std::runtime_error("Command for UAV " + std::to_string(uavNum) + ", but there are only " + std::to_string(slot.size()) + " UAVs");
+		}
+		if (slot[uavNum] == noSlot) {
+			slot[uavNum] = bucket.size();
+			bucket.push_back(command);
+			continue;
+		}
+		Command& kept = bucket[slot[uavNum]];
+		if (kept.getX() == command.getX() && kept.getY() == command.getY())
+			continue;   // ignore duplicate commands
+		kept = command; // a later command in the same tick replaces the earlier one
+	}
+	return bucket;
+}
@@ -0,0 +1,36 @@
+#ifndef COMMAND_SCHEDULER_H
+#define COMMAND_SCHEDULER_H
+
+#include "project_headers.h"
+#include "CommandSource.h"
+#include <memory_resource>
+
+// Groups the commands due at each tick by UAV before they are applied.
+// acceptCommand overwrites everything an earlier command set, so a UAV that gets several commands in
+// one tick only needs the last of them: each UAV is touched at most once per tick, and the per-tick
+// cost depends on the number of commands, not on the fleet size (the per-UAV slots are only reset
+// where they were used).
+// a command repeating the (x, y) of the one currently kept for its UAV is dropped; this never changes
+// which command wins, an A, B, A sequence still ends with A.
+// every list is sized for one command per UAV up front (from the given memory resource, see SimArena),
+// so a tick only allocates when it takes more commands than there are UAVs.
+class CommandScheduler {
+private:
+	CommandSource& source;
+	std::pmr::vector<size_t> slot;       // per UAV: its place in bucket, or noSlot
+	std::pmr::vector<Command> bucket;    // this tick's commands, one per UAV, in the order the UAVs first got one
+
+public:
+	static constexpr size_t noSlot = static_cast<size_t>(-1);
+
+	CommandScheduler(CommandSource& source, const size_t uavCount,
+		std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	// what the constructor takes from its memory resource
+	static size_t memoryBytes(const size_t uavCount);
+
+	// the commands for the tick starting at currentTime - valid until the next call
+	const std::pmr::vector<Command>& collect(const double currentTime);
+};
+
+#endif
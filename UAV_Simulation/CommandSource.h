@@ -0,0 +1,28 @@
+#ifndef COMMAND_SOURCE_H
+#define COMMAND_SOURCE_H
+
+#include "project_headers.h"
+#include "Command.h"
+
+class CheckpointBuffer;
+class CheckpointReader;
+
+// Where the tick loop gets its commands from, in time order.
+// pollDue() is called repeatedly at the start of each tick until it returns false.
+class CommandSource {
+public:
+	virtual ~CommandSource() = default;
+
+	// next command with time <= currentTime, false if none is due yet
+	virtual bool pollDue(const double currentTime, Command& command) = 0;
+
+	// print the commands still waiting (as far as they are known)
+	virtual void show() const = 0;
+
+	// the commands not handed out yet, for a checkpoint. restore is called on a source freshly made
+	// from the same inputs, before its first pollDue
+	virtual void save(CheckpointBuffer& out) const = 0;
+	virtual void restore(CheckpointReader& in) = 0;
+};
+
+#endif
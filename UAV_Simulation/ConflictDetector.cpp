@@ -0,0 +1,140 @@
+#include "ConflictDetector.h"
+#include "Checkpoint.h"
+
+static uint64_t pairKey(const uint32_t a, const uint32_t b) {
+	return (a < b) ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+}
+
+static uint64_t packCell(const int32_t cx, const int32_t cy) {
+	return (uint64_t(uint32_t(cx)) << 32) | uint32_t(cy);
+}
+
+// an open conflict as stored in a checkpoint
+struct SavedConflict {
+	uint64_t pair;
+	double closest;
+};
+
+ConflictDetector::ConflictDetector(const size_t uavCount, const double separation, const std::string& fileName, CheckpointReader* resume)
+	: separation(separation), cellSize(separation), x(uavCount, 0.), y(uavCount, 0.),
+	cellOf(uavCount, 0), slotOf(uavCount, 0), placed(false), conflictCount(0)
+{
+	if (resume != nullptr) {
+		Checkpointer::reopenOutput(events, fileName, resume->get<uint64_t>());
+		conflictCount = static_cast<size_t>(resume->get<uint64_t>());
+		for (const SavedConflict& c : resume->getVector<SavedConflict>())
+			active.emplace(c.pair, c.closest);
+	}
+	else
+		events.open(fileName.c_str());
+	if (!events.is_open()) {
+		throw std::runtime_error("Unable to open file: " + fileName);
+	}
+	events << std::fixed << std::setprecision(2);
+}
+
+uint64_t ConflictDetector::cellKey(const double px, const double py) const {
+	return packCell(static_cast<int32_t>(floor(px / cellSize)), static_cast<int32_t>(floor(py / cellSize)));
+}
+
+void ConflictDetector::moveToCell(const uint32_t uavNum, const uint64_t key) {
+	if (placed) {
+		// swap-remove from the old cell, fixing the slot of the UAV moved into the gap
+		std::vector<uint32_t>& old = cells[cellOf[uavNum]];
+		const uint32_t last = old.back();
+		old[slotOf[uavNum]] = last;
+		slotOf[last] = slotOf[uavNum];
+		old.pop_back();
+		if (old.empty())
+			cells.erase(cellOf[uavNum]);
+	}
+	std::vector<uint32_t>& cell = cells[key];
+	cellOf[uavNum] = key;
+	slotOf[uavNum] = static_cast<uint32_t>(cell.size());
+	cell.push_back(uavNum);
+}
+
+void ConflictDetector::checkPair(const uint32_t a, const uint32_t b) {
+	const double dx = x[a] - x[b], dy = y[a] - y[b];
+	const double squared = dx * dx + dy * dy;
+	if (squared < separation * separation)
+		found.emplace(pairKey(a, b), sqrt(squared));
+}
+
+void ConflictDetector::checkCells(const std::vector<uint32_t>& first, const std::vector<uint32_t>& second) {
+	for (const uint32_t a : first)
+		for (const uint32_t b : second)
+			checkPair(a, b);
+}
+
+void ConflictDetector::endTick(const double time) {
+	for (uint32_t i = 0; i < x.size(); i++) {
+		const uint64_t key = cellKey(x[i], y[i]);
+		if (!placed || key != cellOf[i])
+			moveToCell(i, key);
+	}
+	placed = true;
+
+	// half of the 3x3 neighbourhood, so every pair of cells is looked at once
+	static const int32_t neighbours[4][2] = { { 1, -1 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+	found.clear();
+	for (const auto& cell : cells) {
+		const std::vector<uint32_t>& members = cell.second;
+		if (members.size() > maxCellUavs) {
+			throw std::runtime_error("Separation: " + std::to_string(members.size()) + " UAVs share one grid cell (at most "
+				+ std::to_string(maxCellUavs) + "), place them apart with a Fleet manifest");
+		}
+		for (size_t a = 0; a < members.size(); a++)
+			for (size_t b = a + 1; b < members.size(); b++)
+				checkPair(members[a], members[b]);
+		const int32_t cx = static_cast<int32_t>(cell.first >> 32), cy = static_cast<int32_t>(cell.first & 0xffffffffu);
+		for (const auto& offset : neighbours) {
+			const auto other = cells.find(packCell(cx + offset[0], cy + offset[1]));
+			if (other != cells.end())
+				checkCells(members, other->second);
+		}
+	}
+
+	// compare with the previous tick: new pairs start a conflict, missing pairs end one
+	struct Event {
+		uint64_t pair;
+		bool start;
+		double distance;
+		bool operator<(const Event& other) const { return pair < other.pair; }
+	};
+	std::vector<Event> tickEvents;
+	for (auto& f : found) {
+		const auto previous = active.find(f.first);
+		if (previous == active.end()) {
+			tickEvents.push_back({ f.first, true, f.second });
+			conflictCount++;
+		}
+		else
+			f.second = std::min(f.second, previous->second);
+	}
+	for (const auto& a : active) {
+		if (found.find(a.first) == found.end())
+			tickEvents.push_back({ a.first, false, a.second });
+	}
+	active.swap(found);
+	std::sort(tickEvents.begin(), tickEvents.end());
+	for (const auto& e : tickEvents) {
+		events << time << ((e.start) ? " START " : " END ") << (e.pair >> 32) << ' ' << (e.pair & 0xffffffffu) << ' ' << e.distance << '\n';
+	}
+}
+
+void ConflictDetector::save(CheckpointBuffer& out) {
+	events.flush();
+	out.put<uint64_t>(static_cast<uint64_t>(events.tellp()));
+	out.put<uint64_t>(conflictCount);
+	std::vector<SavedConflict> open;
+	open.reserve(active.size());
+	for (const auto& a : active)
+		open.push_back({ a.first, a.second });
+	out.putVector(open);
+}
+
+void ConflictDetector::close() {
+	if (events.is_open())
+		events.close();
+}
@@ -0,0 +1,64 @@
+#ifndef CONFLICT_DETECTOR_H
+#define CONFLICT_DETECTOR_H
+
+#include "project_headers.h"
+#include <cstdint>
+#include <unordered_map>
+
+class CheckpointBuffer;
+class CheckpointReader;
+
+// Per-tick separation check between UAVs ("Separation" / "ConflictFile" keys).
+// positions go into a hash grid of separation-sized cells, so two UAVs closer than the separation are
+// always in the same or in neighbouring cells: each cell is checked against itself and 4 of its 8
+// neighbours (the other 4 check it back), O(N + pairs found) per tick instead of O(N^2).
+// the grid is updated incrementally - a UAV only moves between cell lists when it crosses a cell border,
+// which at the sample V0 and Dt happens once every few hundred ticks.
+// conflicts are written as events, not per tick: "time START i j distance" when a pair gets closer than
+// the separation, "time END i j closest" when it separates again (i < j, events of a tick sorted by pair).
+// note every UAV starts at X0 / Y0 (unless a Fleet manifest places them), so with more than one UAV each
+// pair starts in conflict. a cell is checked pair by pair, so more than maxCellUavs UAVs in one cell is
+// an error rather than millions of pairs per tick.
+class ConflictDetector {
+private:
+	double separation;
+	double cellSize;
+	std::ofstream events;
+	std::vector<double> x, y;
+	std::vector<uint64_t> cellOf;   // per UAV: key of its cell
+	std::vector<uint32_t> slotOf;   // per UAV: its index in that cell's list
+	std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+	bool placed;                    // false until the first tick put every UAV in the grid
+	std::unordered_map<uint64_t, double> active; // pair -> closest distance so far
+	std::unordered_map<uint64_t, double> found;  // pairs closer than separation this tick
+	size_t conflictCount;
+
+	uint64_t cellKey(const double px, const double py) const;
+	void moveToCell(const uint32_t uavNum, const uint64_t key);
+	void checkPair(const uint32_t a, const uint32_t b);
+	void checkCells(const std::vector<uint32_t>& first, const std::vector<uint32_t>& second);
+
+public:
+	static const size_t maxCellUavs = 256;
+
+	// resume: a checkpoint positioned at the detector's section, to continue its events file and open conflicts
+	ConflictDetector(const size_t uavCount, const double separation, const std::string& fileName, CheckpointReader* resume = nullptr);
+
+	// position of a UAV at the end of the current tick, for every UAV before endTick
+	void setPosition(const size_t uavNum, const double px, const double py) {
+		x[uavNum] = px;
+		y[uavNum] = py;
+	}
+
+	void endTick(const double time);
+
+	// conflicts started so far
+	size_t getConflictCount() const { return conflictCount; }
+
+	// events file size, conflict count and open conflicts (the grid is rebuilt from the next positions)
+	void save(CheckpointBuffer& out);
+
+	void close();
+};
+
+#endif
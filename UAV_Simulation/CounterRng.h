@@ -0,0 +1,57 @@
+#ifndef COUNTER_RNG_H
+#define COUNTER_RNG_H
+
+#include "project_headers.h"
+#include <cstdint>
+
+// Counter-based random numbers: Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3").
+// a random block is a keyed bijection of a 128-bit counter, so there is no generator state - any thread can
+// draw the numbers of any (replica, UAV, tick) directly, and a run gives the same numbers in any order.
+class CounterRng {
+private:
+	uint32_t key[2];
+
+	static void mulhilo(const uint32_t a, const uint32_t b, uint32_t& hi, uint32_t& lo) {
+		const uint64_t product = uint64_t(a) * b;
+		hi = static_cast<uint32_t>(product >> 32);
+		lo = static_cast<uint32_t>(product);
+	}
+
+	// 53 random bits in [0, 1)
+	static double unit(const uint32_t hi, const uint32_t lo) {
+		return static_cast<double>(((uint64_t(hi) << 32) | lo) >> 11) * (1. / 9007199254740992.);
+	}
+
+public:
+	explicit CounterRng(const uint64_t seed) : key{ static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32) } {}
+
+	// the random block of counter (c0, c1, c2, c3)
+	void block(const uint32_t c0, const uint32_t c1, const uint32_t c2, const uint32_t c3, uint32_t out[4]) const {
+		uint32_t c[4] = { c0, c1, c2, c3 };
+		uint32_t k0 = key[0], k1 = key[1];
+		for (int round = 0; round < 10; round++) {
+			uint32_t hi0, lo0, hi1, lo1;
+			mulhilo(0xD2511F53u, c[0], hi0, lo0);
+			mulhilo(0xCD9E8D57u, c[2], hi1, lo1);
+			c[0] = hi1 ^ c[1] ^ k0;
+			c[1] = lo1;
+			c[2] = hi0 ^ c[3] ^ k1;
+			c[3] = lo0;
+			k0 += 0x9E3779B9u;
+			k1 += 0xBB67AE85u;
+		}
+		std::copy(c, c + 4, out);
+	}
+
+	// two independent standard normal values for counter (stream, index) (Box-Muller on the block)
+	void normals(const uint64_t stream, const uint64_t index, double& a, double& b) const {
+		uint32_t r[4];
+		block(static_cast<uint32_t>(index), static_cast<uint32_t>(index >> 32), static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32), r);
+		const double radius = std::sqrt(-2. * std::log(1. - unit(r[0], r[1]))); // 1 - u is in (0, 1]
+		const double angle = 2. * M_PI * unit(r[2], r[3]);
+		a = radius * std::cos(angle);
+		b = radius * std::sin(angle);
+	}
+};
+
+#endif
@@ -0,0 +1,350 @@
+#include "EnsembleRunner.h"
+#include "Simulation.h"
+#include "VectorCommandSource.h"
+#include "CommandScheduler.h"
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+// replicas reduced together before they are merged into the totals - fixed, so the merge order does not
+// depend on the number of workers
+static const size_t blockSize = 16;
+static const size_t noCommand = static_cast<size_t>(-1);
+
+static std::string trimBlanks(const std::string& s) {
+	const size_t start = s.find_first_not_of(" \t\r");
+	const size_t end = s.find_last_not_of(" \t\r");
+	return (start == std::string::npos) ? "" : s.substr(start, end - start + 1);
+}
+
+// one flight step without the verbose messages, returns the state after it
+static UavStates::State quietStep(UAV& uav) {
+	switch (uav.getState()) {
+	case UavStates::CRUISE:
+		return uav.stepIn<UavStates::CRUISE, QuietLog>();
+	case UavStates::PREP_TURN:
+		return uav.stepIn<UavStates::PREP_TURN, QuietLog>();
+	case UavStates::HAS_DEST:
+		return uav.stepIn<UavStates::HAS_DEST, QuietLog>();
+	case UavStates::TURN:
+		return uav.stepIn<UavStates::TURN, QuietLog>();
+	case UavStates::ROTATE:
+		return uav.stepIn<UavStates::ROTATE, QuietLog>();
+	default:
+		throw std::runtime_error("UAV state not-implemented");
+	}
+}
+
+EnsembleRunner::Stats::Stats(const size_t positions, const size_t commands, const size_t bins, const double binWidth)
+	: replicas(0), meanX(positions), meanY(positions), m2X(positions), m2Y(positions), reached(commands),
+	tangentMean(commands), tangentM2(commands), tangentMin(commands), tangentMax(commands), histogram(commands * bins),
+	bins(bins), binWidth(binWidth)
+{
+	clear();
+}
+
+void EnsembleRunner::Stats::clear() {
+	replicas = 0;
+	for (auto* v : { &meanX, &meanY, &m2X, &m2Y, &tangentMean, &tangentM2 })
+		std::fill(v->begin(), v->end(), 0.);
+	std::fill(reached.begin(), reached.end(), 0);
+	std::fill(tangentMin.begin(), tangentMin.end(), HUGE_VAL);
+	std::fill(tangentMax.begin(), tangentMax.end(), -HUGE_VAL);
+	std::fill(histogram.begin(), histogram.end(), 0);
+}
+
+void EnsembleRunner::Stats::addPosition(const size_t position, const double x, const double y) {
+	// Welford
+	const double n = static_cast<double>(replicas);
+	const double dx = x - meanX[position], dy = y - meanY[position];
+	meanX[position] += dx / n;
+	meanY[position] += dy / n;
+	m2X[position] += dx * (x - meanX[position]);
+	m2Y[position] += dy * (y - meanY[position]);
+}
+
+void EnsembleRunner::Stats::addTangentTime(const size_t command, const double time) {
+	const double n = static_cast<double>(++reached[command]);
+	const double d = time - tangentMean[command];
+	tangentMean[command] += d / n;
+	tangentM2[command] += d * (time - tangentMean[command]);
+	tangentMin[command] = std::min(tangentMin[command], time);
+	tangentMax[command] = std::max(tangentMax[command], time);
+	histogram[command * bins + std::min(bins - 1, static_cast<size_t>(time / binWidth))]++;
+}
+
+// the mean and sum of squared deviations of a and b together, into a (Chan, Golub and LeVeque)
+static void mergeMoments(double& meanA, double& m2A, const double countA, const double meanB, const double m2B, const double countB) {
+	const double count = countA + countB;
+	const double d = meanB - meanA;
+	meanA += d * countB / count;
+	m2A += m2B + d * d * countA * countB / count;
+}
+
+void EnsembleRunner::Stats::merge(const Stats& other) {
+	if (other.replicas == 0)
+		return;
+	const double a = static_cast<double>(replicas), b = static_cast<double>(other.replicas);
+	for (size_t k = 0; k < meanX.size(); k++) {
+		mergeMoments(meanX[k], m2X[k], a, other.meanX[k], other.m2X[k], b);
+		mergeMoments(meanY[k], m2Y[k], a, other.meanY[k], other.m2Y[k], b);
+	}
+	replicas += other.replicas;
+	for (size_t c = 0; c < reached.size(); c++) {
+		if (other.reached[c] == 0)
+			continue;
+		mergeMoments(tangentMean[c], tangentM2[c], static_cast<double>(reached[c]), other.tangentMean[c], other.tangentM2[c],
+			static_cast<double>(other.reached[c]));
+		reached[c] += other.reached[c];
+		tangentMin[c] = std::min(tangentMin[c], other.tangentMin[c]);
+		tangentMax[c] = std::max(tangentMax[c], other.tangentMax[c]);
+	}
+	for (size_t k = 0; k < histogram.size(); k++)
+		histogram[k] += other.histogram[k];
+}
+
+EnsembleRunner::Spec EnsembleRunner::readSpec(const std::string& specFile) {
+	std::ifstream file(specFile);
+	if (!file.is_open()) {
+		throw std::runtime_error("Failed to open " + specFile);
+	}
+	Spec spec;
+	std::string line;
+	while (std::getline(file, line)) {
+		line = trimBlanks(line);
+		if (line.empty() || line[0] == '#')
+			continue;
+		const size_t equalsPos = line.find('=');
+		if (equalsPos == std::string::npos)
+			continue;
+		const std::string key = trimBlanks(line.substr(0, equalsPos));
+		const std::string value = trimBlanks(line.substr(equalsPos + 1));
+		if (key == "Config") spec.configFile = value;
+		else if (key == "Commands") spec.commandsFile = value;
+		else if (key == "OutputDirectory") spec.directory = value;
+		else if (key == "Workers") spec.workers = static_cast<size_t>(std::stoul(value));
+		else if (key == "Replicas") spec.replicas = static_cast<size_t>(std::stoul(value));
+		else if (key == "Seed") spec.seed = std::stoull(value);
+		else if (key == "Wind") {
+			const size_t comma = value.find(',');
+			if (comma == std::string::npos) {
+				throw std::runtime_error("Wind needs two values: <x>, <y>");
+			}
+			spec.windX = std::stod(value.substr(0, comma));
+			spec.windY = std::stod(value.substr(comma + 1));
+		}
+		else if (key == "WindSigma") spec.windSigma = std::stod(value);
+		else if (key == "HeadingNoise") spec.headingNoise = std::stod(value);
+		else if (key == "VelocityJitter") spec.velocityJitter = std::stod(value);
+		else if (key == "StatsInterval") spec.statsInterval = std::stod(value);
+		else if (key == "TangentBin") spec.tangentBin = std::stod(value);
+		else {
+			throw std::runtime_error("Unknown ensemble key: " + key);
+		}
+	}
+	if (spec.replicas == 0 || spec.replicas > UINT32_MAX) {
+		throw std::runtime_error("Replicas must be between 1 and " + std::to_string(UINT32_MAX));
+	}
+	if (!(spec.windSigma >= 0.) || !(spec.headingNoise >= 0.) || !(spec.velocityJitter >= 0.)) {
+		throw std::runtime_error("WindSigma, HeadingNoise and VelocityJitter must not be negative");
+	}
+	if (!(spec.statsInterval > 0.) || !(spec.tangentBin > 0.)) {
+		throw std::runtime_error("StatsInterval and TangentBin must be positive");
+	}
+	return spec;
+}
+
+EnsembleRunner::EnsembleRunner(const std::string& specFile)
+	: spec(readSpec(specFile)), config(Simulation::loadConfig(spec.configFile)), manifest(FleetManifest::load(config)),
+	rng(spec.seed), workers(spec.workers),
+	statsStride(std::max<size_t>(1, static_cast<size_t>(std::llround(spec.statsInterval / config.getDt())))),
+	totals(0, 0, 1, 1.), nextBlock(0), mergedBlocks(0)
+{
+	if (manifest.size() > UINT32_MAX) {
+		throw std::runtime_error("The ensemble takes at most " + std::to_string(UINT32_MAX) + " UAVs");
+	}
+	for (size_t t = 0; t < manifest.getTypeCount(); t++)
+		airframes.emplace_back(manifest.getType(t).velocity, manifest.getType(t).turnRadius, config.getDt());
+	commands = Simulation::loadCommandsVectorFromFileSorted(spec.commandsFile, config.getTotalUavs(), config.getCommandCache());
+	VectorCommandSource source(commands);
+	CommandScheduler scheduler(source, manifest.size());
+	std::reverse(commands.begin(), commands.end());
+
+	// the tick times of the run, as the tick loop adds them up, and the commands applied at each
+	std::vector<size_t> kept(manifest.size(), noCommand), chosen(manifest.size(), noCommand);
+	size_t tick = 0, next = 0;
+	for (double currentTime = 0.; currentTime < config.getTimeLimit(); currentTime += config.getDt(), tick++) {
+		if (tick % statsStride == 0)
+			sampleTimes.push_back(currentTime);
+		const auto& bucket = scheduler.collect(currentTime);
+		// the scheduler hands out copies: find each one among the commands it polled (the last of equal ones)
+		for (size_t k = 0; k < bucket.size(); k++)
+			kept[bucket[k].getUavNum()] = k;
+		const size_t first = next;
+		for (; next < commands.size() && commands[next].getTime() <= currentTime; next++) {
+			const size_t uavNum = commands[next].getUavNum();
+			if (kept[uavNum] < bucket.size() && commands[next] == bucket[kept[uavNum]])
+				chosen[uavNum] = next;
+		}
+		for (const auto& c : bucket) {
+			dispatched.push_back(chosen[c.getUavNum()]);
+			dispatchTicks.push_back(tick);
+		}
+		for (size_t k = first; k < next; k++)
+			chosen[commands[k].getUavNum()] = kept[commands[k].getUavNum()] = noCommand;
+	}
+	const size_t bins = static_cast<size_t>(std::ceil(config.getTimeLimit() / spec.tangentBin)) + 1;
+	totals = Stats(sampleTimes.size() * manifest.size(), commands.size(), bins, spec.tangentBin);
+
+	const size_t blocks = (spec.replicas + blockSize - 1) / blockSize;
+	if (workers == 0)
+		workers = std::max(1u, std::thread::hardware_concurrency());
+	workers = std::min(workers, blocks);
+}
+
+void EnsembleRunner::runReplica(const size_t replica, Stats& stats) const {
+	const size_t uavCount = manifest.size();
+	const double dt = config.getDt();
+	std::vector<UAV> uavs;
+	uavs.reserve(uavCount);
+	for (size_t i = 0; i < uavCount; i++) {
+		const FleetManifest::Placement& start = manifest.getPlacement(i);
+		uavs.emplace_back(i, start.x, start.y, start.radianAngle, airframes[start.type]);
+	}
+	std::vector<size_t> pending(uavCount, noCommand); // per UAV, its command whose tangent was not reached yet
+
+	// counter streams: (replica, UAV) with the tick as index, the replica's own values at the last index
+	const uint64_t replicaStream = uint64_t(replica) << 32;
+	double windX = spec.windX, windY = spec.windY;
+	if (spec.windSigma > 0.) {
+		double a, b;
+		rng.normals(replicaStream, UINT64_MAX, a, b);
+		windX += spec.windSigma * a;
+		windY += spec.windSigma * b;
+	}
+	const bool noisy = spec.headingNoise > 0. || spec.velocityJitter > 0.;
+	const double headingStep = spec.headingNoise * std::sqrt(dt);
+	const bool disturbed = noisy || windX != 0. || windY != 0.;
+
+	stats.replicas++;
+	size_t next = 0, tick = 0, sample = 0;
+	for (double currentTime = 0.; currentTime < config.getTimeLimit(); currentTime += dt, tick++) {
+		// the commands the CommandScheduler picked for this tick
+		for (; next < dispatched.size() && dispatchTicks[next] == tick; next++) {
+			const Command& command = commands[dispatched[next]];
+			uavs[command.getUavNum()].acceptCommand<QuietLog>(command);
+			pending[command.getUavNum()] = dispatched[next];
+		}
+		for (size_t i = 0; i < uavCount; i++) {
+			UAV& uav = uavs[i];
+			const UavStates::State before = uav.getState();
+			if (quietStep(uav) == UavStates::ROTATE && before != UavStates::ROTATE && pending[i] != noCommand) {
+				stats.addTangentTime(pending[i], currentTime - commands[pending[i]].getTime());
+				pending[i] = noCommand;
+			}
+			if (!disturbed)
+				continue;
+			double dx = windX * dt, dy = windY * dt, dAngle = 0.;
+			if (noisy) {
+				double heading, speed;
+				rng.normals(replicaStream | i, tick, heading, speed);
+				const double extra = spec.velocityJitter * double(uav.getVelocity()) * dt * speed;
+				dx += extra * std::cos(double(uav.getAngleRad()));
+				dy += extra * std::sin(double(uav.getAngleRad()));
+				dAngle = headingStep * heading;
+			}
+			uav.disturb(dx, dy, dAngle);
+		}
+		if (tick % statsStride == 0) {
+			for (size_t i = 0; i < uavCount; i++)
+				stats.addPosition(sample * uavCount + i, double(uavs[i].getX()), double(uavs[i].getY()));
+			sample++;
+		}
+	}
+}
+
+void EnsembleRunner::workerLoop() {
+	Stats block(totals.meanX.size(), totals.reached.size(), totals.bins, totals.binWidth);
+	for (;;) {
+		size_t b;
+		{
+			std::lock_guard<std::mutex> lock(mergeMutex);
+			if (nextBlock * blockSize >= spec.replicas)
+				return;
+			b = nextBlock++;
+		}
+		block.clear();
+		for (size_t replica = b * blockSize; replica < std::min(spec.replicas, (b + 1) * blockSize); replica++)
+			runReplica(replica, block);
+		// blocks are handed out in order, so the one before is being run and this wait ends
+		std::unique_lock<std::mutex> lock(mergeMutex);
+		merged.wait(lock, [this, b] { return mergedBlocks == b; });
+		totals.merge(block);
+		mergedBlocks++;
+		merged.notify_all();
+	}
+}
+
+void EnsembleRunner::run() {
+	const auto start = std::chrono::steady_clock::now();
+	std::filesystem::create_directories(spec.directory);
+	std::vector<std::thread> threads;
+	for (size_t w = 1; w < workers; w++)
+		threads.emplace_back(&EnsembleRunner::workerLoop, this);
+	workerLoop();
+	for (auto& t : threads)
+		t.join();
+	writeResults();
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	uint64_t reached = 0;
+	for (const uint64_t r : totals.reached)
+		reached += r;
+	std::cout << "Ensemble: " << spec.replicas << " replicas of " << manifest.size() << " UAVs on " << workers << " workers in "
+		<< seconds << " s, " << reached << " of " << commands.size() * spec.replicas << " commands reached their tangent (see "
+		<< spec.directory << ")" << '\n';
+}
+
+void EnsembleRunner::writeResults() const {
+	const double n = static_cast<double>(totals.replicas);
+	const std::string positionsFile = (std::filesystem::path(spec.directory) / "positions.txt").string();
+	std::ofstream positions(positionsFile);
+	if (!positions.is_open()) {
+		throw std::runtime_error("Unable to open file: " + positionsFile);
+	}
+	positions << "# time uavNum meanX meanY stdX stdY (" << totals.replicas << " replicas)" << '\n';
+	for (size_t s = 0; s < sampleTimes.size(); s++) {
+		for (size_t i = 0; i < manifest.size(); i++) {
+			const size_t k = s * manifest.size() + i;
+			const double stdX = (n > 1.) ? std::sqrt(totals.m2X[k] / (n - 1.)) : 0.;
+			const double stdY = (n > 1.) ? std::sqrt(totals.m2Y[k] / (n - 1.)) : 0.;
+			positions << std::fixed << std::setprecision(2) << sampleTimes[s] << ' ' << i << ' ' << totals.meanX[k] << ' ' << totals.meanY[k]
+				<< ' ' << std::setprecision(4) << stdX << ' ' << stdY << '\n';
+		}
+	}
+
+	const std::string tangentFile = (std::filesystem::path(spec.directory) / "tangent.txt").string();
+	std::ofstream tangent(tangentFile);
+	if (!tangent.is_open()) {
+		throw std::runtime_error("Unable to open file: " + tangentFile);
+	}
+	// quantiles from the histogram, at the middle of their bin (within min / max)
+	auto quantile = [this](const size_t c, const double q) {
+		const uint64_t target = static_cast<uint64_t>(std::ceil(q * totals.reached[c]));
+		uint64_t seen = 0;
+		size_t bin = 0;
+		for (; bin + 1 < totals.bins && (seen += totals.histogram[c * totals.bins + bin]) < target; bin++) {}
+		return std::clamp((bin + 0.5) * totals.binWidth, totals.tangentMin[c], totals.tangentMax[c]);
+	};
+	tangent << "# uavNum commandTime reached meanT stdT minT p50 p90 maxT (time to tangent, " << totals.replicas << " replicas)" << '\n';
+	for (size_t c = 0; c < commands.size(); c++) {
+		const uint64_t r = totals.reached[c];
+		tangent << commands[c].getUavNum() << ' ' << std::fixed << std::setprecision(3) << commands[c].getTime() << ' ' << r;
+		if (r > 0) {
+			const double stdT = (r > 1) ? std::sqrt(totals.tangentM2[c] / (r - 1.)) : 0.;
+			tangent << ' ' << totals.tangentMean[c] << ' ' << stdT << ' ' << totals.tangentMin[c] << ' ' << quantile(c, 0.5) << ' '
+				<< quantile(c, 0.9) << ' ' << totals.tangentMax[c];
+		}
+		tangent << '\n';
+	}
+}
@@ -0,0 +1,99 @@
+#ifndef ENSEMBLE_RUNNER_H
+#define ENSEMBLE_RUNNER_H
+
+#include "project_headers.h"
+#include "SimConfig.h"
+#include "FleetManifest.h"
+#include "Command.h"
+#include "UAV.h"
+#include "CounterRng.h"
+#include <condition_variable>
+#include <mutex>
+
+// Monte Carlo ensemble of one scenario ("UAV_Simulation --ensemble <spec>"): N replicas of the objects
+// engine, each flying the same commands (picked per tick by the CommandScheduler, as in a single run)
+// with a disturbance after every flight step - a wind vector, a random walk on the heading and a jitter
+// on the step length. the spec uses the SimParams.ini syntax:
+//   Config = SimParams.ini      scenario (default), Fleet manifests included. the output keys are ignored
+//   Commands = SimCmds.txt      its commands (default)
+//   OutputDirectory = ensemble  where the statistics go (default "ensemble")
+//   Workers = 0                 replicas run at the same time, 0 = one per core (default)
+//   Replicas = 100              ensemble size (default 100)
+//   Seed = 1                    of the random numbers (default 1)
+//   Wind = 0, 0                 mean wind (x, y) in m/s, added to every step (default none)
+//   WindSigma = 0               per replica, a random offset of each wind component, in m/s
+//   HeadingNoise = 0            heading random walk, rad per sqrt(s)
+//   VelocityJitter = 0          standard deviation of each step's length, as a fraction of V0
+//   StatsInterval = 1           seconds between the position statistics (rounded to whole ticks)
+//   TangentBin = 0.1            seconds per bin of the time-to-tangent histograms
+// the random numbers are counter-based (CounterRng): those of (replica, UAV, tick) do not depend on
+// which thread runs the replica or when. replicas are grouped in fixed blocks, each block is reduced in
+// replica order and merged into the totals in block order, so the statistics are the same bit for bit
+// on any number of workers. nothing is written per replica - the statistics are updated on the fly
+// (Welford, Chan et al. for merging), memory is (Workers + 1) * (UAVs * statistics times * 32 bytes +
+// commands * (histogram bins * 4 + 48) bytes), whatever the number of replicas. results:
+//   <OutputDirectory>/positions.txt  per statistics time and UAV: mean and standard deviation of x and y
+//   <OutputDirectory>/tangent.txt    per command: how many replicas reached the tangent of its destination
+//                                    circle before the next command, and the distribution of the time it took
+class EnsembleRunner {
+private:
+	struct Spec {
+		std::string configFile = "SimParams.ini", commandsFile = "SimCmds.txt", directory = "ensemble";
+		size_t workers = 0, replicas = 100;
+		uint64_t seed = 1;
+		double windX = 0., windY = 0., windSigma = 0.;
+		double headingNoise = 0., velocityJitter = 0.;
+		double statsInterval = 1., tangentBin = 0.1;
+	};
+
+	// streaming statistics of a set of replicas
+	struct Stats {
+		uint64_t replicas;
+		std::vector<double> meanX, meanY, m2X, m2Y;   // [sample * uavCount + uav]
+		std::vector<uint64_t> reached;                // per command
+		std::vector<double> tangentMean, tangentM2, tangentMin, tangentMax;
+		std::vector<uint32_t> histogram;              // [command * bins + bin]
+		size_t bins;
+		double binWidth;
+
+		Stats(const size_t positions, const size_t commands, const size_t bins, const double binWidth);
+		void clear();
+		// the sample of the current replica (counted in replicas already)
+		void addPosition(const size_t position, const double x, const double y);
+		void addTangentTime(const size_t command, const double time);
+		// other's replicas added to these (other follows these in replica order)
+		void merge(const Stats& other);
+	};
+
+	const Spec spec;
+	const SimConfig config;
+	const FleetManifest manifest;
+	std::vector<UAV::Airframe> airframes;
+	std::vector<Command> commands; // in time order, same-time commands in file order
+	// the commands the CommandScheduler applies, by index in commands, and the tick of each - the same
+	// for every replica, so they are picked once
+	std::vector<size_t> dispatched, dispatchTicks;
+	const CounterRng rng;
+	size_t workers;
+	size_t statsStride;             // ticks between position samples
+	std::vector<double> sampleTimes;
+
+	Stats totals;
+	size_t nextBlock, mergedBlocks;
+	std::mutex mergeMutex;
+	std::condition_variable merged;
+
+	static Spec readSpec(const std::string& specFile);
+
+	void runReplica(const size_t replica, Stats& stats) const;
+	void workerLoop();
+	void writeResults() const;
+
+public:
+	explicit EnsembleRunner(const std::string& specFile);
+
+	// runs every replica and writes the statistics
+	void run();
+};
+
+#endif
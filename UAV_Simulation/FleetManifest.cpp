@@ -0,0 +1,197 @@
+#include "FleetManifest.h"
+#include "MappedFile.h"
+#include <charconv>
+#include <cstring>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+// smaller manifests are not worth a second thread
+static const size_t minChunkBytes = size_t(1) << 22;
+
+typedef std::unordered_map<std::string_view, uint16_t> TypeIndex;
+
+// a UAV line of one chunk, with its line number within the chunk
+struct ManifestEntry {
+	size_t uavNum, line;
+	FleetManifest::Placement placement;
+};
+
+// what a thread made of its chunk: the UAV lines up to the first invalid one
+struct ManifestChunk {
+	const char* first;
+	const char* last;
+	std::vector<ManifestEntry> entries;
+	size_t lines = 0;
+	size_t errorLine = 0; // within the chunk, 0 = none
+	std::string error;
+};
+
+static const char* skipBlanks(const char* p, const char* last) {
+	while (p < last && (*p == ' ' || *p == '\t' || *p == '\r'))
+		p++;
+	return p;
+}
+
+static std::string_view nextToken(const char*& p, const char* last) {
+	p = skipBlanks(p, last);
+	const char* token = p;
+	while (p < last && *p != ' ' && *p != '\t' && *p != '\r')
+		p++;
+	return std::string_view(token, p - token);
+}
+
+template <typename Number>
+static bool readToken(const char*& p, const char* last, Number& value) {
+	const std::string_view token = nextToken(p, last);
+	const std::from_chars_result r = std::from_chars(token.data(), token.data() + token.size(), value);
+	return !token.empty() && r.ec == std::errc() && r.ptr == token.data() + token.size();
+}
+
+// blank, or only a comment left
+static bool isEmptyLine(const char* p, const char* last) {
+	p = skipBlanks(p, last);
+	return p == last || *p == '#';
+}
+
+static void parseChunk(ManifestChunk& chunk, const TypeIndex& index, const size_t count) {
+	const char* p = chunk.first;
+	while (p < chunk.last) {
+		const char* newline = static_cast<const char*>(memchr(p, '\n', chunk.last - p));
+		const char* last = newline ? newline : chunk.last;
+		chunk.lines++;
+		if (!isEmptyLine(p, last)) {
+			ManifestEntry entry;
+			entry.line = chunk.lines;
+			double azimuth;
+			const char* q = p;
+			const std::string_view number = nextToken(q, last);
+			const std::from_chars_result r = std::from_chars(number.data(), number.data() + number.size(), entry.uavNum);
+			const std::string_view type = nextToken(q, last);
+			const auto found = index.find(type);
+			if (number == "type")
+				chunk.error = "type lines go before the first UAV line";
+			else if (number.empty() || r.ec != std::errc() || r.ptr != number.data() + number.size())
+				chunk.error = "invalid UAV line";
+			else if (found == index.end())
+				chunk.error = "unknown type " + std::string(type);
+			else if (!readToken(q, last, entry.placement.x) || !readToken(q, last, entry.placement.y) || !readToken(q, last, azimuth) || !isEmptyLine(q, last))
+				chunk.error = "invalid UAV line";
+			else if (entry.uavNum >= count)
+				chunk.error = "UAV " + std::to_string(entry.uavNum) + ", but N_uav = " + std::to_string(count);
+			if (!chunk.error.empty()) {
+				chunk.errorLine = chunk.lines;
+				return;
+			}
+			entry.placement.type = found->second;
+			entry.placement.radianAngle = azimuth * M_PI / 180.; // as Az
+			chunk.entries.push_back(entry);
+		}
+		p = newline ? newline + 1 : chunk.last;
+	}
+}
+
+FleetManifest::FleetManifest(const SimConfig& config)
+	: count(config.getTotalUavs()), start{ 0, config.getX(), config.getY(), config.getAngleRad() }
+{
+	types.push_back({ "default", config.getV0(), config.getR0() });
+}
+
+FleetManifest FleetManifest::load(const SimConfig& config, size_t threads) {
+	FleetManifest fleet(config);
+	const std::string& filename = config.getFleet();
+	if (filename.empty())
+		return fleet;
+	const MappedFile file(filename);
+	const char* p = reinterpret_cast<const char*>(file.begin());
+	const char* const end = p + file.size();
+	auto fail = [&filename](const size_t line, const std::string& what) {
+		return std::runtime_error("Fleet manifest " + filename + " at line " + std::to_string(line) + ": " + what);
+	};
+
+	// the type lines, up to the first UAV line
+	TypeIndex index;
+	index.emplace("default", 0);
+	size_t lineNumber = 1;
+	for (; p < end; lineNumber++) {
+		const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+		const char* last = newline ? newline : end;
+		if (!isEmptyLine(p, last)) {
+			const char* q = p;
+			if (nextToken(q, last) != "type")
+				break;
+			const std::string_view name = nextToken(q, last);
+			double velocity, turnRadius;
+			if (name.empty() || !readToken(q, last, velocity) || !readToken(q, last, turnRadius) || !isEmptyLine(q, last))
+				throw fail(lineNumber, "invalid type line");
+			if (!(turnRadius > 0.))
+				throw fail(lineNumber, "R of type " + std::string(name) + " must be positive");
+			if (index.count(name) != 0)
+				throw fail(lineNumber, "type " + std::string(name) + " defined twice");
+			if (fleet.types.size() == maxTypes)
+				throw fail(lineNumber, "more than " + std::to_string(maxTypes) + " types");
+			index.emplace(name, static_cast<uint16_t>(fleet.types.size()));
+			fleet.types.push_back({ std::string(name), velocity, turnRadius });
+		}
+		p = newline ? newline + 1 : end;
+	}
+
+	// the UAV lines, in newline-aligned chunks
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	const size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threads, (end - p) / minChunkBytes));
+	std::vector<ManifestChunk> chunks(chunkCount);
+	for (size_t k = 0; k < chunkCount; k++) {
+		chunks[k].first = (k == 0) ? p : chunks[k - 1].last;
+		const char* last = p + (end - p) * (k + 1) / chunkCount;
+		if (k + 1 < chunkCount && last > chunks[k].first) {
+			const char* newline = static_cast<const char*>(memchr(last - 1, '\n', end - (last - 1)));
+			last = newline ? newline + 1 : end;
+		}
+		chunks[k].last = std::max(last, chunks[k].first);
+	}
+	std::vector<std::thread> workers;
+	for (size_t k = 1; k < chunkCount; k++)
+		workers.emplace_back(parseChunk, std::ref(chunks[k]), std::cref(index), fleet.count);
+	parseChunk(chunks[0], index, fleet.count);
+	for (auto& worker : workers)
+		worker.join();
+
+	// in file order, so the first problem in the file is the one reported
+	fleet.placements.assign(fleet.count, fleet.start);
+	std::vector<unsigned char> listed(fleet.count, 0);
+	for (const ManifestChunk& chunk : chunks) {
+		for (const ManifestEntry& entry : chunk.entries) {
+			if (listed[entry.uavNum])
+				throw fail(lineNumber + entry.line - 1, "UAV " + std::to_string(entry.uavNum) + " listed twice");
+			listed[entry.uavNum] = 1;
+			fleet.placements[entry.uavNum] = entry.placement;
+		}
+		if (chunk.errorLine != 0)
+			throw fail(lineNumber + chunk.errorLine - 1, chunk.error);
+		lineNumber += chunk.lines;
+	}
+	return fleet;
+}
+
+std::vector<FleetManifest::TypeRun> FleetManifest::typeRuns() const {
+	std::vector<TypeRun> runs;
+	for (size_t i = 0; i < count; i++) {
+		const uint16_t type = typeOf(i);
+		if (runs.empty() || runs.back().type != type)
+			runs.push_back({ i, i + 1, type });
+		else
+			runs.back().end = i + 1;
+	}
+	return runs;
+}
+
+void FleetManifest::show() const {
+	std::vector<size_t> perType(types.size(), 0);
+	for (size_t i = 0; i < count; i++)
+		perType[typeOf(i)]++;
+	for (size_t t = 0; t < types.size(); t++) {
+		std::cout << "Type " << types[t].name << ": V0 " << types[t].velocity << ", R " << types[t].turnRadius
+			<< ", " << perType[t] << " UAVs" << '\n';
+	}
+}
@@ -0,0 +1,58 @@
+#ifndef FLEET_MANIFEST_H
+#define FLEET_MANIFEST_H
+
+#include "project_headers.h"
+#include "SimConfig.h"
+#include <cstdint>
+
+// Airframe types and initial states of the fleet ("Fleet = <file>" key). without a manifest every UAV
+// is of the config's type (V0, R) and starts at X0 / Y0 / Az, as before. the manifest is a text file:
+//   # comment
+//   type <name> <V0> <R>                 - every type line comes before the first UAV line
+//   <uavNum> <type> <x> <y> <azimuth>    - azimuth in degrees, as Az
+// type 0 is "default", the config's V0 / R, and UAVs the manifest does not list keep the config's start.
+// the per-type constants are stored once, in the type table; a UAV only keeps the index of its type.
+// the UAV lines are parsed in parallel, in newline-aligned chunks of the mapped file.
+class FleetManifest {
+public:
+	struct Type {
+		std::string name;
+		double velocity, turnRadius;
+	};
+	struct Placement {
+		uint16_t type;
+		double x, y, radianAngle;
+	};
+	// consecutive UAVs of one type, [begin, end)
+	struct TypeRun {
+		size_t begin, end;
+		uint16_t type;
+	};
+	static const size_t maxTypes = 65536;
+
+private:
+	size_t count;
+	std::vector<Type> types;
+	Placement start;                   // of every UAV, without a manifest
+	std::vector<Placement> placements; // per UAV, empty without a manifest
+
+	explicit FleetManifest(const SimConfig& config);
+
+public:
+	// the config's fleet: the manifest of its Fleet key, or every UAV of the default type at X0 / Y0 / Az
+	// (threads = 0 parses with one thread per core)
+	static FleetManifest load(const SimConfig& config, const size_t threads = 0);
+
+	size_t size() const { return count; }
+	size_t getTypeCount() const { return types.size(); }
+	const Type& getType(const size_t type) const { return types[type]; }
+
+	const Placement& getPlacement(const size_t i) const { return placements.empty() ? start : placements[i]; }
+	uint16_t typeOf(const size_t i) const { return placements.empty() ? 0 : placements[i].type; }
+
+	std::vector<TypeRun> typeRuns() const;
+
+	void show() const;
+};
+
+#endif
@@ -0,0 +1,221 @@
+#include "HeadingFleet.h"
+#include "Profiler.h"
+#include "Checkpoint.h"
+
+
+HeadingFleet::HeadingFleet(const FleetManifest& fleet, double dt)
+	: count(fleet.size()), dt(dt), airframe(count), runs(fleet.typeRuns()),
+	x(count), y(count), radianAngle(count), headingX(count), headingY(count),
+	destX(count, 0.), destY(count, 0.), state(count, UAV::State::CRUISE), clockwise(count, 0), rotations(count, 0)
+{
+	for (size_t t = 0; t < fleet.getTypeCount(); t++) {
+		const double velocity = fleet.getType(t).velocity, turnRadius = fleet.getType(t).turnRadius;
+		const double angleStep = (velocity / turnRadius) * dt;
+		const double tolerance = dt * velocity / turnRadius;
+		airframes.push_back({ turnRadius, angleStep, dt * velocity, cos(angleStep), sin(angleStep), tolerance, cos(tolerance),
+			((1.4 + dt) * turnRadius) * ((1.4 + dt) * turnRadius), (2 * turnRadius) * (2 * turnRadius) });
+	}
+	// runs shorter than this on average are not worth a loop each, the kernel looks the type up per drone then
+	const size_t minRunLength = 16;
+	if (runs.size() > 1 && runs.size() * minRunLength > count)
+		runs.clear();
+	for (size_t i = 0; i < count; i++) {
+		const FleetManifest::Placement& start = fleet.getPlacement(i);
+		airframe[i] = start.type;
+		x[i] = start.x;
+		y[i] = start.y;
+		radianAngle[i] = start.radianAngle;
+		resyncHeading(i);
+	}
+}
+
+void HeadingFleet::resyncHeading(const size_t i) {
+	headingX[i] = cos(radianAngle[i]);
+	headingY[i] = sin(radianAngle[i]);
+	rotations[i] = 0;
+}
+
+// UAV::applyAngleChange, plus the same rotation applied to the heading vector
+void HeadingFleet::rotate(const size_t i) {
+	radianAngle[i] = (clockwise[i]) ? radianAngle[i] - airframeOf(i).angleStep : radianAngle[i] + airframeOf(i).angleStep;
+	radianAngle[i] -= (2 * M_PI) * floor(radianAngle[i] / (2 * M_PI));
+	if (++rotations[i] == resyncInterval) {
+		resyncHeading(i);
+		return;
+	}
+	const double s = (clockwise[i]) ? -airframeOf(i).stepSin : airframeOf(i).stepSin;
+	const double hx = headingX[i], hy = headingY[i];
+	headingX[i] = hx * airframeOf(i).stepCos - hy * s;
+	headingY[i] = hx * s + hy * airframeOf(i).stepCos;
+}
+
+void HeadingFleet::confirmArrival(const size_t i) {
+	const double dx = destX[i] - x[i], dy = destY[i] - y[i];
+	const double dist2 = dx * dx + dy * dy;
+	if (dist2 >= airframeOf(i).arrivalDist2) // safety distance from centre, we only check in detail when close enough
+		return;
+	// |normalized dot product| < tolerance, squared (the heading is a unit vector)
+	const double along = headingX[i] * dx + headingY[i] * dy;
+	const bool rightAngle = along * along < airframeOf(i).tolerance * airframeOf(i).tolerance * dist2;
+
+	// project next step's distance, with the next heading when turning
+	double nextHeadingX = headingX[i], nextHeadingY = headingY[i];
+	if (state[i] == UAV::State::TURN) {
+		const double s = (clockwise[i]) ? -airframeOf(i).stepSin : airframeOf(i).stepSin;
+		nextHeadingX = headingX[i] * airframeOf(i).stepCos - headingY[i] * s;
+		nextHeadingY = headingX[i] * s + headingY[i] * airframeOf(i).stepCos;
+	}
+	const double nextDx = dx - airframeOf(i).stepLength * nextHeadingX, nextDy = dy - airframeOf(i).stepLength * nextHeadingY;
+	// if we are at (roughly) 90 degrees angle with vector to center, and we are closest we will be to it, we have arrived
+	if (rightAngle && (dist2 < nextDx * nextDx + nextDy * nextDy)) {
+		if (state[i] != UAV::State::ROTATE) // PREP_TURN falls through to a second check in the same step
+			PROFILE_TRANSITION(UAV::State::ROTATE);
+		state[i] = UAV::State::ROTATE;
+		clockwise[i] = 1; // we are going to rotate clock-wise
+		if (_VERBOSE)
+			std::cout << "Arrived at tangent!\n";
+	}
+}
+
+// UAV::turnLogic without the angles: the tangent direction is the vector to the destination rotated
+// counter-clockwise by theta = asin(R / dist), scaled by dist^2 it is (dx * k - dy * R, dy * k + dx * R)
+// with k = sqrt(dist^2 - R^2). (closer than R, k is NaN and the check fails, as asin does in UAV)
+void HeadingFleet::turnLogic(const size_t i) {
+	const double dx = destX[i] - x[i], dy = destY[i] - y[i];
+	const double dist2 = dx * dx + dy * dy;
+	const double r = airframeOf(i).turnRadius;
+	const double k = sqrt(dist2 - r * r);
+	const double tangentX = dx * k - dy * r, tangentY = dy * k + dx * r;
+	const double hx = headingX[i], hy = headingY[i];
+	bool onTangent = hx * tangentX + hy * tangentY >= airframeOf(i).toleranceCos * dist2;
+	if (onTangent && hx > 0.) {
+		// UAV compares the azimuth in [0, 2pi) with the tangent angle in [0, 2pi + theta) without
+		// wrapping, so a match across the +x axis does not count there either
+		const bool tangentWrapped = dy < 0. && tangentY >= 0.;
+		onTangent = (tangentWrapped) ? hy < 0. : ((hy >= 0.) == (tangentY >= 0.));
+	}
+	if (onTangent) {
+		state[i] = UAV::State::HAS_DEST;
+		PROFILE_TRANSITION(UAV::State::HAS_DEST);
+		return;
+	}
+	rotate(i);
+}
+
+bool HeadingFleet::turnIsPossible(const size_t i) {
+	const double dx = destX[i] - x[i], dy = destY[i] - y[i];
+	if (dx * dx + dy * dy >= airframeOf(i).freeTurnDist2)
+		return true;
+	// centre of the turn circle, the heading rotated by -/+ 90 degrees
+	const double r = airframeOf(i).turnRadius;
+	const double cX = x[i] + ((clockwise[i]) ? r * headingY[i] : -r * headingY[i]);
+	const double cY = y[i] + ((clockwise[i]) ? -r * headingX[i] : r * headingX[i]);
+	const double deltaX = destX[i] - cX;
+	const double deltaY = destY[i] - cY;
+	return (deltaX * deltaX + deltaY * deltaY) >= airframeOf(i).turnRadius; // compared with R as in UAV
+}
+
+void HeadingFleet::handleTurnPreperation(const size_t i) {
+	confirmArrival(i);
+	if (state[i] != UAV::State::ROTATE && turnIsPossible(i)) {
+		state[i] = UAV::State::TURN;
+		PROFILE_TRANSITION(UAV::State::TURN);
+	}
+}
+
+void HeadingFleet::acceptCommand(const Command& command) {
+	const size_t i = command.getUavNum();
+	destX[i] = command.getX();
+	destY[i] = command.getY();
+	state[i] = UAV::State::PREP_TURN;
+	PROFILE_TRANSITION(UAV::State::PREP_TURN);
+	const double angleBetweenVectors =
+		getAngleBetweenTwoVectors(headingX[i], headingY[i], destX[i] - x[i], destY[i] - y[i]);
+	clockwise[i] = (angleBetweenVectors - radianAngle[i] > 180) ? 1 : 0;
+	if (_VERBOSE)
+		std::cout << "UAV#" << i << " received command to move to : " << destX[i] << ", " << destY[i] << "\n";
+}
+
+void HeadingFleet::flightStep(const double currentTime) {
+	// the UAV::flightStep state machine
+	for (size_t i = 0; i < count; i++) {
+		switch (state[i]) {
+		case UAV::State::CRUISE:
+			break;
+		case UAV::State::PREP_TURN:
+			handleTurnPreperation(i);
+			if (state[i] == UAV::State::PREP_TURN)
+				break;
+		case UAV::State::HAS_DEST:
+			confirmArrival(i);
+			break;
+		case UAV::State::TURN:
+			turnLogic(i);
+			break;
+		case UAV::State::ROTATE:
+			rotate(i);
+			break;
+		default:
+			throw std::runtime_error("UAV state not-implemented");
+		}
+	}
+
+	// position update for the whole fleet, no trig
+	double* px = x.data();
+	double* py = y.data();
+	const double* hx = headingX.data();
+	const double* hy = headingY.data();
+	for (const FleetManifest::TypeRun& run : runs) {
+		const double len = airframes[run.type].stepLength;
+		for (size_t i = run.begin; i < run.end; i++) {
+			px[i] = px[i] + len * hx[i];
+			py[i] = py[i] + len * hy[i];
+		}
+	}
+	if (runs.empty()) {
+		const uint16_t* type = airframe.data();
+		const Airframe* table = airframes.data();
+		for (size_t i = 0; i < count; i++) {
+			const double len = table[type[i]].stepLength;
+			px[i] = px[i] + len * hx[i];
+			py[i] = py[i] + len * hy[i];
+		}
+	}
+}
+
+void HeadingFleet::save(CheckpointBuffer& out) const {
+	for (size_t i = 0; i < count; i++) {
+		out.put(x[i]);
+		out.put(y[i]);
+		out.put(radianAngle[i]);
+		out.put(destX[i]);
+		out.put(destY[i]);
+		out.put<uint8_t>(static_cast<uint8_t>(state[i]));
+		out.put<uint8_t>(clockwise[i]);
+		out.put(headingX[i]);
+		out.put(headingY[i]);
+		out.put<uint32_t>(rotations[i]);
+	}
+}
+
+void HeadingFleet::restore(CheckpointReader& in) {
+	for (size_t i = 0; i < count; i++) {
+		x[i] = in.get<double>();
+		y[i] = in.get<double>();
+		radianAngle[i] = in.get<double>();
+		destX[i] = in.get<double>();
+		destY[i] = in.get<double>();
+		const uint8_t s = in.get<uint8_t>();
+		if (s > UAV::State::ROTATE) {
+			throw std::runtime_error("Invalid UAV state in checkpoint");
+		}
+		state[i] = static_cast<UAV::State>(s);
+		clockwise[i] = (in.get<uint8_t>() != 0) ? 1 : 0;
+		headingX[i] = in.get<double>();
+		headingY[i] = in.get<double>();
+		rotations[i] = in.get<uint32_t>();
+		if (rotations[i] >= resyncInterval) {
+			throw std::runtime_error("Invalid heading state in checkpoint");
+		}
+	}
+}
@@ -0,0 +1,93 @@
+#ifndef HEADING_FLEET_H
+#define HEADING_FLEET_H
+
+#include "project_headers.h"
+#include "Command.h"
+#include "UAV.h"
+#include "FleetManifest.h"
+#include "uav_utilities.h"
+
+class CheckpointBuffer;
+class CheckpointReader;
+
+// Structure-of-arrays fleet with a trig-free guidance core: the heading is kept as a unit vector
+// next to the azimuth, so a tick needs no cos/sin/asin/atan2 and no sqrt on the distance checks:
+//  - turning / rotating drones rotate the vector by a precomputed omega * dt rotation matrix,
+//    the azimuth itself is advanced with the same additions as in UAV (bit for bit)
+//  - every resyncInterval rotations the vector is reset from the azimuth, which renormalizes it
+//    and drops the rounding drift of the matrix products
+//  - distance checks compare squared distances, the tangent check compares the heading with the
+//    tangent direction through a dot product (one sqrt, only while turning)
+//  - everything that depends only on velocity / turn radius / dt is cached once per airframe type,
+//    the position update runs over the runs of same-type drones
+// the state machine is the one of UAV, and the tangent check keeps its unwrapped-angle comparison.
+// positions differ from the objects engine only by the vector rounding, the 2-decimal text output
+// is identical for the sample scenario and for 100 UAVs / 400 random commands. a check sitting
+// exactly on its threshold could flip one tick earlier or later, as with UavFleet.
+class HeadingFleet {
+private:
+	// rotations between two resyncs of a heading vector from its azimuth
+	static const unsigned resyncInterval = 64;
+
+	// per-type invariants
+	struct Airframe {
+		double turnRadius;
+		double angleStep;      // omega * dt, as added to the azimuth
+		double stepLength;     // dt * velocity, as used by the position update
+		double stepCos, stepSin; // rotation matrix for angleStep
+		double tolerance;      // dt * velocity / turnRadius, the UAV angle tolerance
+		double toleranceCos;   // cos(tolerance) for the heading / tangent dot product
+		double arrivalDist2;   // ((1.4 + dt) * turnRadius)^2
+		double freeTurnDist2;  // (2 * turnRadius)^2
+	};
+
+	size_t count;
+	double dt;
+
+	std::vector<Airframe> airframes;          // per type
+	std::vector<uint16_t> airframe;           // per drone, index into airframes
+	std::vector<FleetManifest::TypeRun> runs; // of drones sharing a type, empty when the types are interleaved
+
+	std::vector<double> x, y;
+	std::vector<double> radianAngle;
+	std::vector<double> headingX, headingY; // (cos, sin) of radianAngle, up to the rotation drift
+	std::vector<double> destX, destY;
+	std::vector<UAV::State> state;
+	std::vector<unsigned char> clockwise;
+	std::vector<unsigned> rotations; // since the last resync
+
+	const Airframe& airframeOf(const size_t i) const { return airframes[airframe[i]]; }
+
+	void resyncHeading(const size_t i);
+	void rotate(const size_t i);
+
+	// per-drone guidance, same logic as the UAV methods of the same name
+	void confirmArrival(const size_t i);
+	void turnLogic(const size_t i);
+	bool turnIsPossible(const size_t i);
+	void handleTurnPreperation(const size_t i);
+
+public:
+	HeadingFleet(const FleetManifest& fleet, double dt);
+
+	void acceptCommand(const Command& command);
+
+	void flightStep(const double currentTime);
+
+	size_t size() const { return count; }
+
+	double getX(const size_t i) const { return x[i]; }
+	double getY(const size_t i) const { return y[i]; }
+	double getAngleRad(const size_t i) const { return radianAngle[i]; }
+	double getDestX(const size_t i) const { return destX[i]; }
+	double getDestY(const size_t i) const { return destY[i]; }
+	UAV::State getState(const size_t i) const { return state[i]; }
+	bool isClockwise(const size_t i) const { return clockwise[i] != 0; }
+
+	// every drone's flight state for a checkpoint, the UAV::save layout followed by the heading
+	// vector and its rotation count (so a resumed run drifts exactly as an uninterrupted one)
+	void save(CheckpointBuffer& out) const;
+	void restore(CheckpointReader& in);
+};
+
+#endif
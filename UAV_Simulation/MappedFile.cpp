@@ -0,0 +1,86 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+MappedFile::MappedFile(const std::string& fileName)
+	: data(nullptr), length(0), fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr)
+{
+	fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Unable to open file: " + fileName);
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize)) {
+		release();
+		throw std::runtime_error("Unable to read size of file: " + fileName);
+	}
+	length = static_cast<size_t>(fileSize.QuadPart);
+	if (length == 0)
+		return; // nothing to map
+	mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappingHandle != nullptr)
+		data = static_cast<const unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if (data == nullptr) {
+		release();
+		throw std::runtime_error("Unable to map file: " + fileName);
+	}
+}
+
+void MappedFile::release() {
+	if (data != nullptr)
+		UnmapViewOfFile(data);
+	if (mappingHandle != nullptr)
+		CloseHandle(mappingHandle);
+	if (fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(fileHandle);
+	data = nullptr;
+	mappingHandle = nullptr;
+	fileHandle = INVALID_HANDLE_VALUE;
+}
+
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& fileName)
+	: data(nullptr), length(0), fd(-1)
+{
+	fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error("Unable to open file: " + fileName);
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		release();
+		throw std::runtime_error("Unable to read size of file: " + fileName);
+	}
+	length = static_cast<size_t>(info.st_size);
+	if (length == 0)
+		return; // nothing to map
+	void* mapped = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+	if (mapped == MAP_FAILED) {
+		release();
+		throw std::runtime_error("Unable to map file: " + fileName);
+	}
+	data = static_cast<const unsigned char*>(mapped);
+}
+
+void MappedFile::release() {
+	if (data != nullptr)
+		munmap(const_cast<unsigned char*>(data), length);
+	if (fd >= 0)
+		::close(fd);
+	data = nullptr;
+	fd = -1;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+	release();
+}
@@ -0,0 +1,31 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include "project_headers.h"
+
+// Read-only memory mapping of a whole file (mmap on POSIX, a file mapping view on Windows).
+class MappedFile {
+private:
+	const unsigned char* data;
+	size_t length;
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	int fd;
+#endif
+
+	void release();
+
+public:
+	explicit MappedFile(const std::string& fileName);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const unsigned char* begin() const { return data; }
+	size_t size() const { return length; }
+};
+
+#endif
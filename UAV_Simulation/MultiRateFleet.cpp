@@ -0,0 +1,56 @@
+#include "MultiRateFleet.h"
+#include "Checkpoint.h"
+
+
+MultiRateFleet::MultiRateFleet(const FleetManifest& fleet, double dt)
+	: stepsDone(fleet.size(), 0), flightSteps(0)
+{
+	for (size_t t = 0; t < fleet.getTypeCount(); t++)
+		airframes.emplace_back(fleet.getType(t).velocity, fleet.getType(t).turnRadius, dt);
+	uavs.reserve(fleet.size());
+	for (size_t i = 0; i < fleet.size(); i++) {
+		const FleetManifest::Placement& start = fleet.getPlacement(i);
+		uavs.emplace_back(i, start.x, start.y, start.radianAngle, airframes[start.type]);
+	}
+}
+
+void MultiRateFleet::advanceTo(const size_t i, const size_t tick) {
+	UAV& uav = uavs[i];
+	size_t& done = stepsDone[i];
+	while (done < tick) {
+		const size_t quiet = uav.quietSteps(tick - done);
+		if (quiet > 1) {
+			uav.flightSteps(quiet);
+			done += quiet;
+		}
+		else {
+			uav.flightStep(0.);
+			done++;
+		}
+		flightSteps++;
+	}
+}
+
+void MultiRateFleet::acceptCommand(const Command& command, const size_t tick) {
+	advanceTo(command.getUavNum(), tick);
+	uavs[command.getUavNum()].acceptCommand(command);
+}
+
+const UAV& MultiRateFleet::sample(const size_t i, const size_t tick) {
+	advanceTo(i, tick + 1);
+	return uavs[i];
+}
+
+void MultiRateFleet::save(CheckpointBuffer& out, const size_t tick) {
+	for (size_t i = 0; i < uavs.size(); i++) {
+		advanceTo(i, tick);
+		uavs[i].save(out);
+	}
+}
+
+void MultiRateFleet::restore(CheckpointReader& in, const size_t tick) {
+	for (size_t i = 0; i < uavs.size(); i++) {
+		uavs[i].restore(in);
+		stepsDone[i] = tick;
+	}
+}
@@ -0,0 +1,53 @@
+#ifndef MULTI_RATE_FLEET_H
+#define MULTI_RATE_FLEET_H
+
+#include "project_headers.h"
+#include "Command.h"
+#include "UAV.h"
+#include "FleetManifest.h"
+
+class CheckpointBuffer;
+class CheckpointReader;
+
+// Multi-rate version of a vector of UAV objects: every UAV keeps its own step count and is only
+// advanced when the run needs it at some tick - for a command, a written sample, the separation
+// check or a checkpoint. on the way it takes as few flight steps as it can:
+//  - while UAV::quietSteps says the flight state cannot change, one closed-form step covers the
+//    whole stretch (UAV::flightSteps) - CRUISE and ROTATE only end with a command, HAS_DEST and TURN
+//    are bounded by how fast the arrival / turn-completion checks can approach their thresholds
+//  - near those events (and in PREP_TURN) it falls back to single UAV::flightStep calls, so
+//    transitions happen on the same tick as in the tick engines
+// the closed forms are the sums of the per-tick Euler steps, so trajectories match the objects
+// engine up to their rounding, and the output grid is sampled exactly: the 2-decimal output is the
+// same, except that an azimuth within rounding of 0 may print as 360.00. with every tick written a
+// UAV needs a step per tick anyway - the gain comes with output decimation or Output = none.
+// (in a UAV_FLOAT32 build the closed forms skip most of the per-step float rounding, so they stay
+// closer to the double trajectories than float stepping does.)
+class MultiRateFleet {
+private:
+	std::vector<UAV::Airframe> airframes; // per type, the UAVs point into it
+	std::vector<UAV> uavs;
+	std::vector<size_t> stepsDone; // flight steps taken so far, i.e. the tick each UAV is at
+	size_t flightSteps;            // single and closed-form steps, over the whole run
+
+	// move UAV i to the start of tick
+	void advanceTo(const size_t i, const size_t tick);
+
+public:
+	MultiRateFleet(const FleetManifest& fleet, double dt);
+
+	// command applied at the start of tick
+	void acceptCommand(const Command& command, const size_t tick);
+
+	// UAV i after its step of tick (ticks must not go back for that UAV)
+	const UAV& sample(const size_t i, const size_t tick);
+
+	size_t size() const { return uavs.size(); }
+	size_t getFlightSteps() const { return flightSteps; }
+
+	// the checkpoint of the objects engine, every UAV brought to the start of tick first
+	void save(CheckpointBuffer& out, const size_t tick);
+	void restore(CheckpointReader& in, const size_t tick);
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef MULTI_TRAJECTORY_SINK_H
+#define MULTI_TRAJECTORY_SINK_H
+
+#include "TrajectorySink.h"
+#include <memory>
+
+// hands every sample to several sinks, e.g. the text files and the binary file side by side
+class MultiTrajectorySink : public TrajectorySink {
+private:
+	std::vector<std::unique_ptr<TrajectorySink>> sinks;
+
+public:
+	void add(std::unique_ptr<TrajectorySink> sink) { sinks.push_back(std::move(sink)); }
+
+	size_t size() const { return sinks.size(); }
+
+	void record(const size_t uavNum, const double time, const double x, const double y, const double radianAngle) override {
+		for (auto& s : sinks)
+			s->record(uavNum, time, x, y, radianAngle);
+	}
+
+	void endTick() override {
+		for (auto& s : sinks)
+			s->endTick();
+	}
+
+	void checkpoint(std::vector<uint64_t>& offsets) override {
+		for (auto& s : sinks)
+			s->checkpoint(offsets);
+	}
+
+	void close() override {
+		for (auto& s : sinks)
+			s->close();
+	}
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include "OutputDecimator.h"
+#include "Checkpoint.h"
+
+static const size_t noTick = static_cast<size_t>(-1);
+
+OutputDecimator::OutputDecimator(const SimConfig& config, const FleetManifest& fleet)
+	: stride(std::max<size_t>(config.getOutputStride(), 1)), interval(config.getOutputInterval()), tolerance(config.getOutputTolerance()),
+	airframe(config.getTotalUavs()), nextTickTime(0.),
+	lastTick(config.getTotalUavs(), noTick), lastState(config.getTotalUavs(), UAV::State::CRUISE),
+	baseX(config.getTotalUavs(), 0.), baseY(config.getTotalUavs(), 0.),
+	stepX(config.getTotalUavs(), 0.), stepY(config.getTotalUavs(), 0.),
+	centreX(config.getTotalUavs(), 0.), centreY(config.getTotalUavs(), 0.),
+	nextTime(config.getTotalUavs(), 0.)
+{
+	for (size_t t = 0; t < fleet.getTypeCount(); t++) {
+		const double stepLength = fleet.getType(t).velocity * config.getDt();
+		const double stepAngle = fleet.getType(t).velocity / fleet.getType(t).turnRadius * config.getDt();
+		// a turning UAV moves along the chords of a circle (one chord per tick, the heading turns by stepAngle
+		// between chords) - these are that circle's dimensions, relative to the middle of a chord
+		airframes.push_back({ stepLength, stepAngle, (stepLength / 2) / tan(stepAngle / 2), (stepLength / 2) / sin(stepAngle / 2) });
+	}
+	for (size_t i = 0; i < airframe.size(); i++)
+		airframe[i] = fleet.typeOf(i);
+}
+
+bool OutputDecimator::tickWanted(const size_t tick, const double time, const bool lastTick) {
+	if (isAdaptive())
+		return true;
+	if (interval > 0.) {
+		const bool wanted = tick == 0 || lastTick || time >= nextTickTime;
+		while (nextTickTime <= time)
+			nextTickTime += interval;
+		return wanted;
+	}
+	return tick == 0 || lastTick || tick % stride == 0;
+}
+
+void OutputDecimator::remember(const size_t uavNum, const size_t tick, const double time, const double x, const double y,
+	const double radianAngle, const UAV::State state, const bool clockwise) {
+	lastTick[uavNum] = tick;
+	lastState[uavNum] = state;
+	const double stepLength = airframes[airframe[uavNum]].stepLength, chordCentre = airframes[airframe[uavNum]].chordCentre;
+	baseX[uavNum] = x;
+	baseY[uavNum] = y;
+	const double c = cos(radianAngle), s = sin(radianAngle);
+	stepX[uavNum] = stepLength * c;
+	stepY[uavNum] = stepLength * s;
+	// the chord arriving at this sample runs along radianAngle, the centre sits on its perpendicular bisector
+	const double side = clockwise ? -1. : 1.;
+	centreX[uavNum] = x - (stepLength / 2) * c - side * chordCentre * s;
+	centreY[uavNum] = y - (stepLength / 2) * s + side * chordCentre * c;
+	if (interval > 0.) {
+		while (nextTime[uavNum] <= time)
+			nextTime[uavNum] += interval;
+	}
+}
+
+bool OutputDecimator::sampleWanted(const size_t uavNum, const size_t tick, const double time, const bool lastTick,
+	const double x, const double y, const double radianAngle, const UAV::State state, const bool clockwise) {
+	if (!isAdaptive())
+		return true; // tickWanted already decided for the whole fleet
+	bool wanted = tick == 0 || lastTick || this->lastTick[uavNum] == noTick || state != lastState[uavNum]
+		|| (interval > 0. && time >= nextTime[uavNum]);
+	if (!wanted) {
+		const double ticks = static_cast<double>(tick - this->lastTick[uavNum]);
+		const Airframe& type = airframes[airframe[uavNum]];
+		if (state == UAV::State::TURN || state == UAV::State::ROTATE) {
+			// off the circle, or more than a quarter of the way around it
+			const double radial = vec2DDist(centreX[uavNum], centreY[uavNum], x, y) - type.chordRadius;
+			wanted = fabs(radial) > tolerance || ticks * type.stepAngle > M_PI_2;
+		}
+		else {
+			const double dx = x - (baseX[uavNum] + ticks * stepX[uavNum]);
+			const double dy = y - (baseY[uavNum] + ticks * stepY[uavNum]);
+			wanted = (dx * dx + dy * dy) > tolerance * tolerance;
+		}
+	}
+	if (wanted)
+		remember(uavNum, tick, time, x, y, radianAngle, state, clockwise);
+	return wanted;
+}
+
+void OutputDecimator::save(CheckpointBuffer& out) const {
+	out.put(nextTickTime);
+	out.putVector(lastTick);
+	out.putVector(lastState);
+	out.putVector(baseX);
+	out.putVector(baseY);
+	out.putVector(stepX);
+	out.putVector(stepY);
+	out.putVector(centreX);
+	out.putVector(centreY);
+	out.putVector(nextTime);
+}
+
+// a vector of the checkpoint, which has to hold one value per UAV
+template <typename T>
+static void restorePerUav(CheckpointReader& in, std::vector<T>& values) {
+	std::vector<T> restored = in.getVector<T>();
+	if (restored.size() != values.size()) {
+		throw std::runtime_error("Checkpoint does not match the number of UAVs");
+	}
+	values.swap(restored);
+}
+
+void OutputDecimator::restore(CheckpointReader& in) {
+	nextTickTime = in.get<double>();
+	restorePerUav(in, lastTick);
+	restorePerUav(in, lastState);
+	restorePerUav(in, baseX);
+	restorePerUav(in, baseY);
+	restorePerUav(in, stepX);
+	restorePerUav(in, stepY);
+	restorePerUav(in, centreX);
+	restorePerUav(in, centreY);
+	restorePerUav(in, nextTime);
+}
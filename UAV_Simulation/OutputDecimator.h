@@ -0,0 +1,67 @@
+#ifndef OUTPUT_DECIMATOR_H
+#define OUTPUT_DECIMATOR_H
+
+#include "project_headers.h"
+#include "SimConfig.h"
+#include "UAV.h"
+#include "FleetManifest.h"
+
+class CheckpointBuffer;
+class CheckpointReader;
+
+// Decides which samples the tick loop hands to the TrajectorySink ("OutputStride", "OutputInterval"
+// and "OutputTolerance" keys). By default every UAV is written every tick.
+//  - stride:   every Nth tick
+//  - interval: the first tick at or after every multiple of T seconds (takes precedence over stride)
+//  - adaptive (tolerance > 0): a UAV is written when its state changed, or when the motion since its
+//    last written sample no longer matches what a reader would reconstruct from that sample - a straight
+//    line in CRUISE / HAS_DEST / PREP_TURN, a circle in TURN / ROTATE - by more than the tolerance.
+//    a circle is also cut every quarter turn so the reader can interpolate along it. when an interval is
+//    set it works as the longest allowed gap between two samples of a UAV.
+// the first and the last tick are always written in full.
+// tickWanted() is the whole-fleet decision, only when it is true does the loop call sampleWanted() per UAV.
+class OutputDecimator {
+private:
+	size_t stride;
+	double interval;
+	double tolerance;
+	// per airframe type
+	struct Airframe {
+		double stepLength;  // distance flown per tick (V0 * Dt)
+		double stepAngle;   // heading change per tick while turning (omega * Dt)
+		double chordCentre; // distance from the middle of a step to the turn centre
+		double chordRadius; // radius of the circle through the per-tick positions while turning
+	};
+	std::vector<Airframe> airframes;
+	std::vector<uint16_t> airframe; // per UAV
+	double nextTickTime; // regular (non-adaptive) interval grid
+
+	// per UAV, describing the last written sample
+	std::vector<size_t> lastTick;
+	std::vector<UAV::State> lastState;
+	std::vector<double> baseX, baseY;     // position
+	std::vector<double> stepX, stepY;     // straight line: position change per tick
+	std::vector<double> centreX, centreY; // circle: centre
+	std::vector<double> nextTime;         // adaptive interval (max gap)
+
+	void remember(const size_t uavNum, const size_t tick, const double time, const double x, const double y,
+		const double radianAngle, const UAV::State state, const bool clockwise);
+
+public:
+	OutputDecimator(const SimConfig& config, const FleetManifest& fleet);
+
+	bool isAdaptive() const { return tolerance > 0.; }
+
+	// false when no UAV at all is written on this tick
+	bool tickWanted(const size_t tick, const double time, const bool lastTick);
+
+	// per UAV decision, only meaningful (and only needed) after tickWanted returned true
+	bool sampleWanted(const size_t uavNum, const size_t tick, const double time, const bool lastTick,
+		const double x, const double y, const double radianAngle, const UAV::State state, const bool clockwise);
+
+	// the interval grid and every UAV's last written sample, for a checkpoint
+	void save(CheckpointBuffer& out) const;
+	void restore(CheckpointReader& in);
+};
+
+#endif
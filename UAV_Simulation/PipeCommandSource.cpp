@@ -0,0 +1,89 @@
+#include "PipeCommandSource.h"
+#include "StreamingCommandSource.h"
+#include "Checkpoint.h"
+
+static const int pollMs = 50; // how often the reader looks at the stop flag while the pipe is quiet
+
+PipeCommandSource::PipeCommandSource(std::unique_ptr<CommandSource> base, const std::string& pipeName, const size_t uavCount)
+	: base(std::move(base)), pipe(pipeName), uavCount(uavCount), hasArrived(false), received(0), stopping(false)
+{
+	reader = std::thread(&PipeCommandSource::readerLoop, this);
+}
+
+PipeCommandSource::~PipeCommandSource() {
+	stopping.store(true, std::memory_order_release);
+	reader.join();
+}
+
+void PipeCommandSource::readerLoop() {
+	std::vector<char> buffer(1 << 16);
+	std::string partial; // a line split over two reads
+	size_t lineNumber = 0;
+	while (!stopping.load(std::memory_order_acquire)) {
+		const size_t bytes = pipe.read(buffer.data(), buffer.size(), pollMs);
+		if (bytes == 0)
+			continue;
+		partial.append(buffer.data(), bytes);
+		std::vector<Command> parsed;
+		size_t begin = 0;
+		for (size_t newline; (newline = partial.find('\n', begin)) != std::string::npos; begin = newline + 1) {
+			lineNumber++;
+			const char* first = partial.data() + begin;
+			const char* last = partial.data() + newline;
+			if (last > first && last[-1] == '\r')
+				last--;
+			if (first == last)
+				continue;
+			Command command;
+			if (!StreamingCommandSource::parseLine(first, last, command))
+				std::cerr << "Warning: invalid command on " << pipe.getName() << " (line " << lineNumber << "), skipped" << '\n';
+			else if (command.getUavNum() >= uavCount)
+				std::cerr << "Warning: command for UAV " << command.getUavNum() << " on " << pipe.getName() << " (line " << lineNumber
+					<< ") but N_uav = " << uavCount << ", skipped" << '\n';
+			else
+				parsed.push_back(command);
+		}
+		partial.erase(0, begin);
+		if (!parsed.empty()) {
+			std::lock_guard<std::mutex> lock(arrivedMutex);
+			arrived.insert(arrived.end(), parsed.begin(), parsed.end());
+			hasArrived.store(true, std::memory_order_release);
+		}
+	}
+}
+
+bool PipeCommandSource::pollDue(const double currentTime, Command& command) {
+	if (base->pollDue(currentTime, command))
+		return true;
+	if (hasArrived.exchange(false, std::memory_order_acquire)) {
+		std::lock_guard<std::mutex> lock(arrivedMutex);
+		for (const auto& c : arrived)
+			injected.push({ c, received++ });
+		arrived.clear();
+	}
+	if (injected.empty() || currentTime < injected.top().command.getTime())
+		return false;
+	command = injected.top().command;
+	injected.pop();
+	return true;
+}
+
+void PipeCommandSource::show() const {
+	base->show();
+	std::cout << "Commands also injected through " << pipe.getName() << "\n";
+}
+
+void PipeCommandSource::save(CheckpointBuffer& out) const {
+	base->save(out);
+	std::vector<Command> waiting;
+	waiting.reserve(injected.size());
+	for (auto copy = injected; !copy.empty(); copy.pop())
+		waiting.push_back(copy.top().command);
+	out.putVector(waiting);
+}
+
+void PipeCommandSource::restore(CheckpointReader& in) {
+	base->restore(in);
+	for (const Command& c : in.getVector<Command>())
+		injected.push({ c, received++ });
+}
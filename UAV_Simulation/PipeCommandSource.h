@@ -0,0 +1,60 @@
+#ifndef PIPE_COMMAND_SOURCE_H
+#define PIPE_COMMAND_SOURCE_H
+
+#include "CommandSource.h"
+#include "CommandPipe.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+// Commands from the commands file plus commands injected at runtime through a CommandPipe
+// ("CommandPipe" key). a background thread reads the pipe and parses "time uavNum x y" lines like the
+// file; the tick thread picks them up in pollDue, so they go through the same CommandScheduler dispatch.
+// an injected command is applied at the first tick starting at or after its time (time 0 = next tick),
+// after the file's commands of that tick. invalid lines (and commands for UAVs outside the fleet) are
+// reported and skipped, the run goes on.
+class PipeCommandSource : public CommandSource {
+private:
+	struct Pending {
+		Command command;
+		size_t sequence; // arrival order, keeps same-time commands in order
+	};
+	struct ComesLater {
+		bool operator()(const Pending& a, const Pending& b) const {
+			if (a.command.getTime() != b.command.getTime())
+				return a.command.getTime() > b.command.getTime();
+			return a.sequence > b.sequence;
+		}
+	};
+
+	std::unique_ptr<CommandSource> base;
+	CommandPipe pipe;
+	size_t uavCount;
+
+	std::mutex arrivedMutex;
+	std::vector<Command> arrived;        // parsed by the reader, not yet seen by the tick thread
+	std::atomic<bool> hasArrived;        // lets pollDue skip the lock when nothing came in
+	std::priority_queue<Pending, std::vector<Pending>, ComesLater> injected; // tick thread only
+	size_t received;
+
+	std::atomic<bool> stopping;
+	std::thread reader;
+
+	void readerLoop();
+
+public:
+	PipeCommandSource(std::unique_ptr<CommandSource> base, const std::string& pipeName, const size_t uavCount);
+	~PipeCommandSource() override;
+
+	bool pollDue(const double currentTime, Command& command) override;
+
+	void show() const override;
+
+	// the base source plus the injected commands waiting for their time (lines still in the pipe are not covered)
+	void save(CheckpointBuffer& out) const override;
+	void restore(CheckpointReader& in) override;
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "Profiler.h"
+
+static const char* phaseNames[Profiler::PHASE_COUNT] = { "commands", "flight", "output", "conflicts" };
+static const char* stateNames[Profiler::stateCount] = { "CRUISE", "HAS_DEST", "PREP_TURN", "TURN", "ROTATE" };
+
+Profiler::Profiler() {
+	reset();
+}
+
+Profiler& Profiler::get() {
+	static Profiler profiler;
+	return profiler;
+}
+
+void Profiler::reset() {
+	for (auto& p : phaseNanos)
+		p = 0;
+	for (auto& c : counters)
+		c.store(0, std::memory_order_relaxed);
+	for (auto& t : transitions)
+		t.store(0, std::memory_order_relaxed);
+	for (auto& b : tickBuckets)
+		b = 0;
+	tickTotal = tickMax = 0;
+}
+
+// values below 16 get a bucket each, above that every power of two is split into 16 equal parts
+size_t Profiler::bucketOf(const uint64_t nanos) {
+	if (nanos < subBuckets)
+		return static_cast<size_t>(nanos);
+	size_t shift = 0;
+	while ((nanos >> shift) >= 2 * subBuckets)
+		shift++;
+	return subBuckets + shift * subBuckets + static_cast<size_t>((nanos >> shift) - subBuckets);
+}
+
+// largest value falling into a bucket
+uint64_t Profiler::bucketTop(const size_t bucket) {
+	if (bucket < subBuckets)
+		return bucket;
+	const size_t shift = (bucket - subBuckets) / subBuckets;
+	const uint64_t lower = static_cast<uint64_t>(subBuckets + (bucket - subBuckets) % subBuckets) << shift;
+	return lower + (uint64_t(1) << shift) - 1;
+}
+
+void Profiler::addTick(const uint64_t nanos) {
+	tickBuckets[bucketOf(nanos)]++;
+	tickTotal += nanos;
+	tickMax = std::max(tickMax, nanos);
+	counters[COUNT_TICKS].fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t Profiler::tickPercentile(const double fraction) const {
+	const uint64_t ticks = counters[COUNT_TICKS].load(std::memory_order_relaxed);
+	if (ticks == 0)
+		return 0;
+	const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(ceil(fraction * ticks)));
+	uint64_t seen = 0;
+	for (size_t b = 0; b < bucketCount; b++) {
+		seen += tickBuckets[b];
+		if (seen >= rank)
+			return std::min(bucketTop(b), tickMax);
+	}
+	return tickMax;
+}
+
+void Profiler::report(std::ostream& out) const {
+	const uint64_t ticks = counters[COUNT_TICKS].load(std::memory_order_relaxed);
+	uint64_t phaseTotal = 0;
+	for (const auto p : phaseNanos)
+		phaseTotal += p;
+	out << "\n - - - Profile - - - \n";
+	out << "Ticks: " << ticks << ", commands applied: " << counters[COUNT_COMMANDS].load(std::memory_order_relaxed)
+		<< ", bytes written: " << counters[COUNT_BYTES].load(std::memory_order_relaxed) << '\n';
+	out << std::fixed << std::setprecision(3);
+	for (size_t p = 0; p < PHASE_COUNT; p++) {
+		out << "Phase " << phaseNames[p] << ": " << phaseNanos[p] * 1e-9 << " s ("
+			<< ((phaseTotal > 0) ? 100. * phaseNanos[p] / phaseTotal : 0.) << "%)\n";
+	}
+	out << "Tick latency (us): mean " << ((ticks > 0) ? tickTotal * 1e-3 / ticks : 0.) << ", p50 " << tickPercentile(0.5) * 1e-3
+		<< ", p99 " << tickPercentile(0.99) * 1e-3 << ", max " << tickMax * 1e-3 << '\n';
+	out << "State transitions:";
+	for (size_t s = 0; s < stateCount; s++)
+		out << ' ' << stateNames[s] << ' ' << transitions[s].load(std::memory_order_relaxed);
+	out << '\n';
+}
+
+void Profiler::reportJson(std::ostream& out) const {
+	const uint64_t ticks = counters[COUNT_TICKS].load(std::memory_order_relaxed);
+	out << "{\n  \"ticks\": " << ticks
+		<< ",\n  \"commandsApplied\": " << counters[COUNT_COMMANDS].load(std::memory_order_relaxed)
+		<< ",\n  \"bytesWritten\": " << counters[COUNT_BYTES].load(std::memory_order_relaxed)
+		<< ",\n  \"phaseNanos\": {";
+	for (size_t p = 0; p < PHASE_COUNT; p++)
+		out << ((p > 0) ? ", " : " ") << '"' << phaseNames[p] << "\": " << phaseNanos[p];
+	out << " },\n  \"tickNanos\": { \"mean\": " << ((ticks > 0) ? tickTotal / ticks : 0) << ", \"p50\": " << tickPercentile(0.5)
+		<< ", \"p99\": " << tickPercentile(0.99) << ", \"max\": " << tickMax << " },\n  \"stateTransitions\": {";
+	for (size_t s = 0; s < stateCount; s++)
+		out << ((s > 0) ? ", " : " ") << '"' << stateNames[s] << "\": " << transitions[s].load(std::memory_order_relaxed);
+	out << " }\n}\n";
+}
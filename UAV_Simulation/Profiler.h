@@ -0,0 +1,104 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "project_headers.h"
+#include "UAV.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// build with UAV_PROFILE=1 to get the instrumentation below, otherwise every PROFILE_ macro is empty
+#ifndef UAV_PROFILE
+#define UAV_PROFILE 0
+#endif
+
+// Run-wide phase timers, counters and a per-tick latency histogram, filled by the PROFILE_ macros.
+// phases and ticks are timed on the tick thread only (a steady_clock read at each scope edge), counters
+// are relaxed atomics since UAVs change state and sinks write from worker / writer threads.
+// the histogram is log-linear: 16 sub-buckets per power of two, so a percentile is within 1/16 of the
+// true latency (max is exact).
+class Profiler {
+public:
+	enum Phase {
+		PHASE_COMMANDS, // fetching and applying the commands due at a tick
+		PHASE_FLIGHT,   // stepping the UAVs
+		PHASE_OUTPUT,   // decimation and handing samples to the sink
+		PHASE_CONFLICTS, // separation check (ConflictDetector)
+		PHASE_COUNT
+	};
+	enum Counter {
+		COUNT_TICKS, COUNT_COMMANDS, COUNT_BYTES, COUNT_COUNT
+	};
+	static const size_t stateCount = UAV::State::ROTATE + 1;
+
+private:
+	static const size_t subBuckets = 16;
+	static const size_t bucketCount = 64 * subBuckets;
+
+	uint64_t phaseNanos[PHASE_COUNT];
+	std::atomic<uint64_t> counters[COUNT_COUNT];
+	std::atomic<uint64_t> transitions[stateCount];
+	uint64_t tickBuckets[bucketCount];
+	uint64_t tickTotal, tickMax;
+
+	static size_t bucketOf(const uint64_t nanos);
+	static uint64_t bucketTop(const size_t bucket);
+	uint64_t tickPercentile(const double fraction) const;
+
+public:
+	Profiler();
+
+	// the instance the PROFILE_ macros report to
+	static Profiler& get();
+
+	void reset();
+
+	void addPhase(const Phase phase, const uint64_t nanos) { phaseNanos[phase] += nanos; }
+	void addTick(const uint64_t nanos);
+	void count(const Counter counter, const uint64_t n) { counters[counter].fetch_add(n, std::memory_order_relaxed); }
+	void transition(const UAV::State state) { transitions[state].fetch_add(1, std::memory_order_relaxed); }
+
+	// human readable summary / the same numbers as one JSON object
+	void report(std::ostream& out) const;
+	void reportJson(std::ostream& out) const;
+
+	static uint64_t now() {
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+};
+
+// adds the time until the end of the enclosing scope to a phase
+class ProfilePhaseTimer {
+private:
+	Profiler::Phase phase;
+	uint64_t start;
+public:
+	explicit ProfilePhaseTimer(const Profiler::Phase phase) : phase(phase), start(Profiler::now()) {}
+	~ProfilePhaseTimer() { Profiler::get().addPhase(phase, Profiler::now() - start); }
+};
+
+// one tick: counts it and puts its duration (until the end of the enclosing scope) in the histogram
+class ProfileTickTimer {
+private:
+	uint64_t start;
+public:
+	ProfileTickTimer() : start(Profiler::now()) {}
+	~ProfileTickTimer() { Profiler::get().addTick(Profiler::now() - start); }
+};
+
+#if UAV_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_PHASE(phase) ProfilePhaseTimer PROFILE_CONCAT(profilePhase, __LINE__)(Profiler::phase)
+#define PROFILE_TICK() ProfileTickTimer PROFILE_CONCAT(profileTick, __LINE__)
+#define PROFILE_COUNT(counter, n) Profiler::get().count(Profiler::counter, (n))
+#define PROFILE_TRANSITION(state) Profiler::get().transition(state)
+#else
+#define PROFILE_PHASE(phase) ((void)0)
+#define PROFILE_TICK() ((void)0)
+#define PROFILE_COUNT(counter, n) ((void)0)
+#define PROFILE_TRANSITION(state) ((void)0)
+#endif
+
+#endif
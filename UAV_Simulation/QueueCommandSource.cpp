@@ -0,0 +1,73 @@
+#include "QueueCommandSource.h"
+#include "Checkpoint.h"
+
+QueueCommandSource::QueueCommandSource(std::unique_ptr<CommandSource> base, CommandQueue& queue, const size_t uavCount)
+	: base(std::move(base)), queue(queue), uavCount(uavCount), drainedAt(-HUGE_VAL), hasBaseNext(false)
+{
+}
+
+void QueueCommandSource::drain() {
+	CommandQueue::Entry entry;
+	while (queue.tryPop(entry)) {
+		if (entry.command.getUavNum() >= uavCount) {
+			std::cerr << "Warning: queued command for UAV " << entry.command.getUavNum() << " (producer " << entry.producer
+				<< ") but N_uav = " << uavCount << ", skipped" << '\n';
+			continue;
+		}
+		injected.push(entry);
+	}
+}
+
+bool QueueCommandSource::pollDue(const double currentTime, Command& command) {
+	if (currentTime != drainedAt) {
+		drain();
+		drainedAt = currentTime;
+	}
+	if (!hasBaseNext)
+		hasBaseNext = base->pollDue(currentTime, baseNext);
+	const bool queuedDue = !injected.empty() && injected.top().command.getTime() <= currentTime;
+	if (hasBaseNext && (!queuedDue || baseNext.getTime() <= injected.top().command.getTime())) {
+		command = baseNext;
+		hasBaseNext = false;
+		return true;
+	}
+	if (!queuedDue)
+		return false;
+	command = injected.top().command;
+	injected.pop();
+	return true;
+}
+
+void QueueCommandSource::show() const {
+	base->show();
+	std::cout << "Commands also pushed through a command queue of " << queue.capacity() << " entries\n";
+}
+
+void QueueCommandSource::save(CheckpointBuffer& out) const {
+	// checkpoints are taken between ticks, when every due base command was handed out
+	base->save(out);
+	// with their producers and sequence numbers, so a resumed run orders same-time commands the same way
+	std::vector<Command> waiting;
+	std::vector<uint32_t> producers;
+	std::vector<uint64_t> sequences;
+	for (auto copy = injected; !copy.empty(); copy.pop()) {
+		waiting.push_back(copy.top().command);
+		producers.push_back(copy.top().producer);
+		sequences.push_back(copy.top().sequence);
+	}
+	out.putVector(waiting);
+	out.putVector(producers);
+	out.putVector(sequences);
+}
+
+void QueueCommandSource::restore(CheckpointReader& in) {
+	base->restore(in);
+	const std::vector<Command> waiting = in.getVector<Command>();
+	const std::vector<uint32_t> producers = in.getVector<uint32_t>();
+	const std::vector<uint64_t> sequences = in.getVector<uint64_t>();
+	if (producers.size() != waiting.size() || sequences.size() != waiting.size()) {
+		throw std::runtime_error("Invalid checkpoint");
+	}
+	for (size_t k = 0; k < waiting.size(); k++)
+		injected.push({ waiting[k], producers[k], sequences[k] });
+}
@@ -0,0 +1,51 @@
+#ifndef QUEUE_COMMAND_SOURCE_H
+#define QUEUE_COMMAND_SOURCE_H
+
+#include "CommandSource.h"
+#include "CommandQueue.h"
+#include <memory>
+#include <queue>
+
+// Commands from the commands file plus commands pushed into a CommandQueue by other threads while the run
+// goes on ("CommandQueue" key, Simulation::getCommandQueue). the queue is drained once per tick, at the
+// first pollDue of the tick, and its commands wait in a heap until their time. due commands of both
+// sources come out merged by time: the file's first at equal times, then the queue's by producer id and
+// the producer's own push order - so a run is reproducible whenever every command is pushed before the
+// tick it is due in. a command pushed after its time is applied at the next tick (time 0 = next tick),
+// commands for UAVs outside the fleet are reported and skipped.
+class QueueCommandSource : public CommandSource {
+private:
+	struct ComesLater {
+		bool operator()(const CommandQueue::Entry& a, const CommandQueue::Entry& b) const {
+			if (a.command.getTime() != b.command.getTime())
+				return a.command.getTime() > b.command.getTime();
+			if (a.producer != b.producer)
+				return a.producer > b.producer;
+			return a.sequence > b.sequence;
+		}
+	};
+
+	std::unique_ptr<CommandSource> base;
+	CommandQueue& queue;
+	size_t uavCount;
+
+	std::priority_queue<CommandQueue::Entry, std::vector<CommandQueue::Entry>, ComesLater> injected;
+	double drainedAt;     // time of the tick the queue was last drained in
+	Command baseNext;     // due command of the base source not handed out yet
+	bool hasBaseNext;
+
+	void drain();
+
+public:
+	QueueCommandSource(std::unique_ptr<CommandSource> base, CommandQueue& queue, const size_t uavCount);
+
+	bool pollDue(const double currentTime, Command& command) override;
+
+	void show() const override;
+
+	// the base source plus the drained commands waiting for their time (commands still in the queue are not covered)
+	void save(CheckpointBuffer& out) const override;
+	void restore(CheckpointReader& in) override;
+};
+
+#endif
@@ -0,0 +1,176 @@
+#include "ShardProcess.h"
+#include <mutex>
+
+// pipe ends are inheritable for a moment while a child starts, so children are started one at a time:
+// otherwise a second child could inherit the write end of the first one's input, which then never ends
+static std::mutex startMutex;
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+// command line of CreateProcess, every argument quoted (arguments here never end in a backslash)
+static std::string quoteArgument(const std::string& argument) {
+	std::string quoted = "\"";
+	for (const char c : argument) {
+		if (c == '"')
+			quoted += '\\';
+		quoted += c;
+	}
+	return quoted + "\"";
+}
+
+ShardProcess::ShardProcess(const std::string& executable, const std::vector<std::string>& arguments)
+	: process(nullptr), input(nullptr)
+{
+	std::string commandLine = quoteArgument(executable);
+	for (const auto& argument : arguments)
+		commandLine += " " + quoteArgument(argument);
+
+	std::lock_guard<std::mutex> lock(startMutex);
+	SECURITY_ATTRIBUTES inherit = { sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE };
+	HANDLE readEnd = nullptr, writeEnd = nullptr;
+	if (!CreatePipe(&readEnd, &writeEnd, &inherit, 0)) {
+		throw std::runtime_error("Unable to create pipe for " + executable);
+	}
+	SetHandleInformation(writeEnd, HANDLE_FLAG_INHERIT, 0);
+	STARTUPINFOA startup = {};
+	startup.cb = sizeof(startup);
+	startup.dwFlags = STARTF_USESTDHANDLES;
+	startup.hStdInput = readEnd;
+	startup.hStdOutput = GetStdHandle(STD_OUTPUT_HANDLE);
+	startup.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+	PROCESS_INFORMATION info = {};
+	const BOOL started = CreateProcessA(nullptr, &commandLine[0], nullptr, nullptr, TRUE, 0, nullptr, nullptr, &startup, &info);
+	CloseHandle(readEnd);
+	if (!started) {
+		CloseHandle(writeEnd);
+		throw std::runtime_error("Unable to start " + executable);
+	}
+	CloseHandle(info.hThread);
+	process = info.hProcess;
+	input = writeEnd;
+}
+
+bool ShardProcess::write(const char* data, size_t size) {
+	while (size > 0) {
+		DWORD written = 0;
+		if (!WriteFile(input, data, static_cast<DWORD>(std::min<size_t>(size, 1 << 30)), &written, nullptr))
+			return false;
+		data += written;
+		size -= written;
+	}
+	return true;
+}
+
+void ShardProcess::closeInput() {
+	if (input != nullptr)
+		CloseHandle(input);
+	input = nullptr;
+}
+
+int ShardProcess::wait() {
+	closeInput();
+	if (process == nullptr)
+		return -1;
+	WaitForSingleObject(process, INFINITE);
+	DWORD code = 0;
+	GetExitCodeProcess(process, &code);
+	CloseHandle(process);
+	process = nullptr;
+	return static_cast<int>(code);
+}
+
+std::string ShardProcess::currentExecutable(const std::string& argv0) {
+	char path[MAX_PATH];
+	const DWORD length = GetModuleFileNameA(nullptr, path, MAX_PATH);
+	return (length > 0 && length < MAX_PATH) ? std::string(path, length) : argv0;
+}
+
+#else
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <filesystem>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+ShardProcess::ShardProcess(const std::string& executable, const std::vector<std::string>& arguments)
+	: pid(-1), input(-1)
+{
+	// a worker that exits before reading its input must not take us down with SIGPIPE
+	std::signal(SIGPIPE, SIG_IGN);
+	std::vector<char*> argv;
+	argv.push_back(const_cast<char*>(executable.c_str()));
+	for (const auto& argument : arguments)
+		argv.push_back(const_cast<char*>(argument.c_str()));
+	argv.push_back(nullptr);
+
+	std::lock_guard<std::mutex> lock(startMutex);
+	int ends[2];
+	if (pipe(ends) != 0) {
+		throw std::runtime_error("Unable to create pipe for " + executable);
+	}
+	fcntl(ends[1], F_SETFD, FD_CLOEXEC);
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, ends[0], STDIN_FILENO);
+	posix_spawn_file_actions_addclose(&actions, ends[0]);
+	pid_t child;
+	const int error = posix_spawnp(&child, executable.c_str(), &actions, nullptr, argv.data(), environ);
+	posix_spawn_file_actions_destroy(&actions);
+	::close(ends[0]);
+	if (error != 0) {
+		::close(ends[1]);
+		throw std::runtime_error("Unable to start " + executable);
+	}
+	pid = child;
+	input = ends[1];
+}
+
+bool ShardProcess::write(const char* data, size_t size) {
+	while (size > 0) {
+		const ssize_t written = ::write(input, data, size);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		data += written;
+		size -= static_cast<size_t>(written);
+	}
+	return true;
+}
+
+void ShardProcess::closeInput() {
+	if (input >= 0)
+		::close(input);
+	input = -1;
+}
+
+int ShardProcess::wait() {
+	closeInput();
+	if (pid < 0)
+		return -1;
+	int status = 0;
+	while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+	}
+	pid = -1;
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+std::string ShardProcess::currentExecutable(const std::string& argv0) {
+	std::error_code error;
+	const std::filesystem::path self = std::filesystem::read_symlink("/proc/self/exe", error); // Linux
+	return error ? argv0 : self.string();
+}
+
+#endif
+
+ShardProcess::~ShardProcess() {
+	wait();
+}
@@ -0,0 +1,37 @@
+#ifndef SHARD_PROCESS_H
+#define SHARD_PROCESS_H
+
+#include "project_headers.h"
+
+// A child process of the sharded mode, started with its standard input connected to a pipe we write
+// (posix_spawn on POSIX, CreateProcess on Windows). standard output and error are shared with us.
+// the pipe is the only channel to the child: write its input, closeInput(), then wait() for it.
+class ShardProcess {
+private:
+#ifdef _WIN32
+	void* process;
+	void* input;
+#else
+	int pid;
+	int input;
+#endif
+
+public:
+	ShardProcess(const std::string& executable, const std::vector<std::string>& arguments);
+	~ShardProcess();
+
+	ShardProcess(const ShardProcess&) = delete;
+	ShardProcess& operator=(const ShardProcess&) = delete;
+
+	// false if the child stopped reading (it exited early, wait() tells why)
+	bool write(const char* data, size_t size);
+	void closeInput();
+
+	// blocks until the child exits, returns its exit code (-1 if it was killed)
+	int wait();
+
+	// path of the running executable, to start workers of the same build (argv0 if it cannot be found)
+	static std::string currentExecutable(const std::string& argv0);
+};
+
+#endif
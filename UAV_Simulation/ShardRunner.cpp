@@ -0,0 +1,211 @@
+#include "ShardRunner.h"
+#include "ShardProcess.h"
+#include "Simulation.h"
+#include "VectorCommandSource.h"
+#include "TextTrajectorySink.h"
+#include "TrajectoryReader.h"
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <thread>
+
+static const char* const inputSeparator = "\n%%\n";
+
+// appends a value that std::from_chars reads back exactly
+template <typename Number>
+static void appendNumber(std::string& out, const Number value) {
+	char digits[32];
+	out.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+}
+
+ShardRunner::ShardRunner(const std::string& executable, const std::string& configFile, const std::string& commandsFile, size_t shardCount)
+	: executable(executable), config(Simulation::loadConfig(configFile))
+{
+	if (config.getSeparation() > 0. || config.getCheckpointInterval() > 0. || !config.getResumeFrom().empty() || !config.getCommandPipe().empty() ||
+		config.getCommandQueue() > 0 || !config.getFleet().empty()) {
+		throw std::runtime_error("--shards does not support Separation, checkpoints, CommandPipe, CommandQueue or Fleet");
+	}
+	std::ifstream file(configFile, std::ios::binary);
+	const std::string configText((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	const size_t uavCount = config.getTotalUavs();
+	shardCount = std::clamp<size_t>(shardCount, 1, uavCount);
+	const std::string binaryName = std::filesystem::path(config.getBinaryFile()).filename().string();
+	std::vector<size_t> owner(uavCount);
+	for (size_t k = 0; k < shardCount; k++) {
+		Shard shard;
+		shard.firstUav = k * uavCount / shardCount;
+		shard.uavCount = (k + 1) * uavCount / shardCount - shard.firstUav;
+		shard.directory = (std::filesystem::path(config.getOutputDirectory()) / ("shard" + std::to_string(k))).string();
+		// later keys win, so the shard's values go after the run's own
+		shard.input = configText + "\n# shard " + std::to_string(k) + "\nN_uav = " + std::to_string(shard.uavCount) +
+			"\nOutputDirectory = " + shard.directory + "\nBinaryFile = " + binaryName +
+			"\nCommandInput = eager\nCommandCache = " + inputSeparator;
+		shard.commandCount = 0;
+		shard.seconds = 0.;
+		shard.exitCode = -1;
+		std::fill(owner.begin() + shard.firstUav, owner.begin() + shard.firstUav + shard.uavCount, k);
+		shards.push_back(std::move(shard));
+	}
+
+	// route the sorted commands, keeping their order within each shard
+	for (const Command& command : Simulation::loadCommandsVectorFromFileSorted(commandsFile, uavCount, config.getCommandCache())) {
+		Shard& shard = shards[owner[command.getUavNum()]];
+		std::string& out = shard.input;
+		appendNumber(out, command.getTime());
+		out += ' ';
+		appendNumber(out, command.getUavNum() - shard.firstUav);
+		out += ' ';
+		appendNumber(out, command.getX());
+		out += ' ';
+		appendNumber(out, command.getY());
+		out += '\n';
+		shard.commandCount++;
+	}
+}
+
+void ShardRunner::runShard(Shard& shard) {
+	const auto start = std::chrono::steady_clock::now();
+	try {
+		ShardProcess worker(executable, { "--shard-worker" });
+		worker.write(shard.input.data(), shard.input.size()); // a worker that stopped reading reports through its exit code
+		std::string().swap(shard.input);
+		shard.exitCode = worker.wait();
+	}
+	catch (const std::exception& e) {
+		std::cerr << "Error: " << shard.directory << ": " << e.what() << '\n';
+		shard.exitCode = -1;
+	}
+	shard.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+size_t ShardRunner::run() {
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (auto& shard : shards)
+		threads.emplace_back(&ShardRunner::runShard, this, std::ref(shard));
+	for (auto& t : threads)
+		t.join();
+	size_t failed = 0;
+	for (const auto& shard : shards) {
+		if (shard.exitCode != 0) {
+			std::cerr << "Error: " << shard.directory << " (UAVs " << shard.firstUav << " - " << shard.firstUav + shard.uavCount - 1
+				<< ") failed with exit code " << shard.exitCode << '\n';
+			failed++;
+		}
+	}
+	// a failed run keeps every shard's directory as it is
+	if (failed == 0)
+		mergeOutputs();
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	const std::string summaryFile = config.outputPath("shards.txt");
+	std::ofstream summary(summaryFile);
+	if (!summary.is_open()) {
+		throw std::runtime_error("Unable to open file: " + summaryFile);
+	}
+	for (size_t k = 0; k < shards.size(); k++) {
+		const Shard& s = shards[k];
+		summary << "shard" << k << " UAVs " << s.firstUav << " - " << s.firstUav + s.uavCount - 1 << ' ' << s.commandCount << " commands "
+			<< std::fixed << std::setprecision(3) << s.seconds << "s " << ((s.exitCode == 0) ? "ok" : "failed: exit code " + std::to_string(s.exitCode)) << '\n';
+	}
+	std::cout << "Shards: " << config.getTotalUavs() << " UAVs on " << shards.size() << " worker processes in " << seconds << " s, "
+		<< failed << " failed (see " << summaryFile << ")" << '\n';
+	return failed;
+}
+
+void ShardRunner::mergeOutputs() const {
+	if (config.getOutput() != SimConfig::Output::NO_TEXT) {
+		for (const auto& shard : shards) {
+			for (size_t i = 0; i < shard.uavCount; i++) {
+				std::filesystem::rename(TextTrajectorySink::fileName(shard.directory, i),
+					TextTrajectorySink::fileName(config.getOutputDirectory(), shard.firstUav + i));
+			}
+		}
+	}
+	const std::string binaryName = std::filesystem::path(config.getBinaryFile()).filename().string();
+	if (config.getBinaryOutput() != SimConfig::BinaryOutput::BINARY_NONE) {
+		std::vector<std::string> parts;
+		for (const auto& shard : shards)
+			parts.push_back((std::filesystem::path(shard.directory) / binaryName).string());
+		mergeTrajectoryFiles(parts, config.outputPath(config.getBinaryFile()));
+		for (const auto& part : parts)
+			std::filesystem::remove(part);
+	}
+	// only empty directories go, anything else a worker wrote (a profile, ...) stays where it is
+	for (const auto& shard : shards) {
+		std::error_code notEmpty;
+		std::filesystem::remove(shard.directory, notEmpty);
+	}
+}
+
+void ShardRunner::mergeTrajectoryFiles(const std::vector<std::string>& parts, const std::string& target) {
+	std::vector<std::unique_ptr<TrajectoryReader>> readers;
+	for (const auto& part : parts)
+		readers.push_back(std::make_unique<TrajectoryReader>(part));
+	TrajectoryFileHeader header = readers.front()->getHeader();
+	header.uavCount = header.sampleCount = header.chunkCount = header.chunkCapacity = header.markerCount = 0;
+
+	std::ofstream file(target, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		throw std::runtime_error("Unable to open file: " + target);
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	uint64_t fileEnd = sizeof(header);
+	std::vector<TrajectoryUavEntry> uavEntries;
+	std::vector<TrajectoryChunkEntry> chunkEntries;
+	std::vector<TrajectoryMarker> markers;
+	for (const auto& reader : readers) {
+		const TrajectoryFileHeader& part = reader->getHeader();
+		if (part.encoding != header.encoding) {
+			throw std::runtime_error("Shard trajectory files with different encodings");
+		}
+		// the chunks are copied as they are, only their offsets move
+		const uint64_t shift = fileEnd - sizeof(part);
+		file.write(reinterpret_cast<const char*>(reader->getData() + sizeof(part)), part.indexOffset - sizeof(part));
+		fileEnd += part.indexOffset - sizeof(part);
+		for (size_t i = 0; i < reader->getUavCount(); i++) {
+			uavEntries.push_back({ chunkEntries.size(), reader->getChunkCount(i), reader->getSampleCount(i), markers.size(), reader->getMarkerCount(i) });
+			for (size_t c = 0; c < reader->getChunkCount(i); c++) {
+				TrajectoryChunkEntry chunk = reader->getChunk(i, c);
+				chunk.offset += shift;
+				chunkEntries.push_back(chunk);
+			}
+			for (size_t m = 0; m < reader->getMarkerCount(i); m++)
+				markers.push_back(reader->getMarker(i, m));
+		}
+		header.uavCount += part.uavCount;
+		header.sampleCount += part.sampleCount;
+		header.chunkCount += part.chunkCount;
+		header.markerCount += part.markerCount;
+		header.chunkCapacity = std::max(header.chunkCapacity, part.chunkCapacity);
+	}
+	header.indexOffset = fileEnd;
+	file.write(reinterpret_cast<const char*>(uavEntries.data()), uavEntries.size() * sizeof(TrajectoryUavEntry));
+	file.write(reinterpret_cast<const char*>(chunkEntries.data()), chunkEntries.size() * sizeof(TrajectoryChunkEntry));
+	file.write(reinterpret_cast<const char*>(markers.data()), markers.size() * sizeof(TrajectoryMarker));
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.close();
+	if (file.fail()) {
+		throw std::runtime_error("Unable to write file: " + target);
+	}
+}
+
+int ShardRunner::runWorker(std::istream& in) {
+	const std::string input((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	const size_t separator = input.find(inputSeparator);
+	if (separator == std::string::npos) {
+		throw std::runtime_error("Invalid shard input");
+	}
+	std::istringstream configText(input.substr(0, separator));
+	const SimConfig config = Simulation::parseConfig(configText);
+	const char* commands = input.data() + separator + std::strlen(inputSeparator);
+	Simulation sim(config, std::make_unique<VectorCommandSource>(
+		Simulation::parseCommands(commands, input.data() + input.size(), "shard input", config.getTotalUavs())));
+	sim.run();
+	return 0;
+}
@@ -0,0 +1,55 @@
+#ifndef SHARD_RUNNER_H
+#define SHARD_RUNNER_H
+
+#include "project_headers.h"
+#include "SimConfig.h"
+#include "Command.h"
+
+// Sharded run of one simulation over several processes ("UAV_Simulation --shards <N>").
+// UAVs never interact, so the fleet is cut into N contiguous ranges of UAV numbers and each range runs
+// as an independent Simulation in its own worker process (the same executable, "--shard-worker").
+// the coordinator loads and sorts the commands once and routes each one to the shard owning its UAV.
+// a worker gets everything over its standard input, nothing else is shared:
+//   <SimParams.ini text: the run's own, then N_uav / OutputDirectory / ... of the shard>
+//   %%
+//   <the shard's commands as "time uavNum x y" lines, UAV numbers counted from the shard's first UAV,
+//    in VectorCommandSource order (latest first), so the worker runs them without sorting>
+// every worker writes into <OutputDirectory>/shard<k>/. once all succeeded the merge step moves the text
+// files to their global names (UAV<first + i>.txt), merges the shards' binary trajectory files into one
+// file with a single index over all UAVs, and lists the shards in <OutputDirectory>/shards.txt.
+// per-UAV results are those of the single-process run; the separation check (it needs every pair of
+// UAVs), checkpoints, CommandPipe / CommandQueue and a Fleet manifest (it numbers UAVs globally) are not available in this mode.
+class ShardRunner {
+private:
+	struct Shard {
+		size_t firstUav, uavCount;
+		std::string directory;
+		std::string input;  // for the worker, released once it was sent
+		size_t commandCount;
+		double seconds;
+		int exitCode;
+	};
+
+	std::string executable;
+	SimConfig config;
+	std::vector<Shard> shards;
+
+	void runShard(Shard& shard);
+	void mergeOutputs() const;
+
+	// the trajectory files of the shards, in UAV order, as one file
+	static void mergeTrajectoryFiles(const std::vector<std::string>& parts, const std::string& target);
+
+public:
+	ShardRunner(const std::string& executable, const std::string& configFile, const std::string& commandsFile, size_t shardCount);
+
+	size_t getShardCount() const { return shards.size(); }
+
+	// runs every shard and merges their outputs, returns how many shards failed
+	size_t run();
+
+	// the worker side: reads the shard from in and runs it, returns the process exit code
+	static int runWorker(std::istream& in);
+};
+
+#endif
@@ -0,0 +1,31 @@
+#include "SharedCommandSource.h"
+#include "Checkpoint.h"
+
+SharedCommandSource::SharedCommandSource(std::shared_ptr<const std::vector<Command>> sortedCommands)
+	: commands(std::move(sortedCommands)), remaining(commands->size())
+{
+}
+
+bool SharedCommandSource::pollDue(const double currentTime, Command& command) {
+	if (remaining == 0 || currentTime < (*commands)[remaining - 1].getTime())
+		return false;
+	command = (*commands)[--remaining];
+	return true;
+}
+
+void SharedCommandSource::show() const {
+	for (size_t i = 0; i < remaining; i++)
+		(*commands)[i].showCommand();
+}
+
+void SharedCommandSource::save(CheckpointBuffer& out) const {
+	out.putVector(std::vector<Command>(commands->begin(), commands->begin() + remaining));
+}
+
+void SharedCommandSource::restore(CheckpointReader& in) {
+	const size_t restored = in.getVector<Command>().size();
+	if (restored > commands->size()) {
+		throw std::runtime_error("Checkpoint does not match the commands file");
+	}
+	remaining = restored;
+}
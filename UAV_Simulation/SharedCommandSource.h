@@ -0,0 +1,27 @@
+#ifndef SHARED_COMMAND_SOURCE_H
+#define SHARED_COMMAND_SOURCE_H
+
+#include "CommandSource.h"
+#include <memory>
+
+// the commands file loaded and sorted once, read by many runs at the same time (batch mode).
+// the list is never modified - each source only keeps its own position in it, so a sweep of
+// thousands of scenarios holds a single copy of the commands.
+class SharedCommandSource : public CommandSource {
+private:
+	std::shared_ptr<const std::vector<Command>> commands; // sorted latest first, like VectorCommandSource
+	size_t remaining; // commands[0, remaining) were not handed out yet
+
+public:
+	explicit SharedCommandSource(std::shared_ptr<const std::vector<Command>> sortedCommands);
+
+	bool pollDue(const double currentTime, Command& command) override;
+
+	void show() const override;
+
+	// same layout as VectorCommandSource
+	void save(CheckpointBuffer& out) const override;
+	void restore(CheckpointReader& in) override;
+};
+
+#endif
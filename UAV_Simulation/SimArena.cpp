@@ -0,0 +1,73 @@
+#include "SimArena.h"
+#include <cassert>
+
+SimArena::SimArena(const size_t capacity)
+	: block(new unsigned char[capacity]), capacity(capacity), used(0)
+{
+}
+
+void* SimArena::do_allocate(const size_t bytes, const size_t alignment) {
+	const size_t start = (used + alignment - 1) & ~(alignment - 1);
+	if (start > capacity || bytes > capacity - start) {
+		throw std::runtime_error("Arena exhausted: " + std::to_string(bytes) + " more bytes needed, " +
+			std::to_string(capacity - used) + " of " + std::to_string(capacity) + " left");
+	}
+	used = start + bytes;
+	return block.get() + start;
+}
+
+void SimArena::do_deallocate(void* p, const size_t bytes, const size_t alignment) {
+	(void)p;
+	(void)bytes;
+	(void)alignment;
+}
+
+bool SimArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+	return this == &other;
+}
+
+#ifdef NDEBUG
+static const bool checkAllocations = false;
+#else
+static const bool checkAllocations = true;
+#endif
+
+// where allocations made on this thread are counted, null when it is not attached to a scope
+static thread_local std::atomic<size_t>* allocationCounter = nullptr;
+
+void NoAllocationScope::countAllocation() {
+	if (allocationCounter)
+		allocationCounter->fetch_add(1, std::memory_order_relaxed);
+}
+
+NoAllocationScope::NoAllocationScope(const bool enabled)
+	: enabled(enabled && checkAllocations), allocations(0), previous(allocationCounter)
+{
+	if (this->enabled)
+		allocationCounter = &allocations;
+}
+
+NoAllocationScope::~NoAllocationScope() {
+	if (enabled)
+		allocationCounter = previous;
+}
+
+void NoAllocationScope::check() {
+	if (!enabled)
+		return;
+	// the workers are past the tick barrier, their counts are in
+	assert(allocations.load(std::memory_order_relaxed) == 0 && "heap allocation inside the tick loop");
+	allocations.store(0, std::memory_order_relaxed);
+}
+
+NoAllocationScope::Thread::Thread(NoAllocationScope& scope)
+	: previous(allocationCounter), attached(scope.enabled)
+{
+	if (attached)
+		allocationCounter = &scope.allocations;
+}
+
+NoAllocationScope::Thread::~Thread() {
+	if (attached)
+		allocationCounter = previous;
+}
@@ -0,0 +1,69 @@
+#ifndef SIM_ARENA_H
+#define SIM_ARENA_H
+
+#include "project_headers.h"
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+
+// One memory block for everything the tick loop touches in the allocation-free mode (Arena = on):
+// the UAVs, the commands, the scheduler's per-tick lists and the output rings. allocation is a
+// pointer bump, deallocation does nothing - the block is released with the arena, after the run.
+// containers take it as a std::pmr::memory_resource, and are sized before the tick loop, so the
+// loop itself never allocates. running out of room throws instead of falling back to the heap.
+class SimArena : public std::pmr::memory_resource {
+private:
+	std::unique_ptr<unsigned char[]> block;
+	size_t capacity;
+	size_t used;
+
+protected:
+	void* do_allocate(const size_t bytes, const size_t alignment) override;
+	void do_deallocate(void* p, const size_t bytes, const size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+public:
+	explicit SimArena(const size_t capacity);
+
+	size_t getCapacity() const { return capacity; }
+	size_t getUsed() const { return used; }
+};
+
+// Debug check of the allocation-free mode: while a scope is open, every operator new on a thread attached
+// to it is counted, and check() asserts that nothing was allocated since the scope opened or the previous
+// check. the scope attaches the tick thread, the tick workers (Threads > 1) attach for their share of each
+// tick (Thread). the background writer of Output = async is not attached and not checked.
+// the counting operator new is AllocationCounter.cpp, linked into the UAV_Simulation program only - the
+// library does not replace the allocator of every program using it, elsewhere the check sees nothing.
+// in NDEBUG builds it does nothing.
+class NoAllocationScope {
+private:
+	bool enabled;
+	std::atomic<size_t> allocations;
+	std::atomic<size_t>* previous; // the counter this thread had before
+
+public:
+	explicit NoAllocationScope(const bool enabled);
+	~NoAllocationScope();
+
+	NoAllocationScope(const NoAllocationScope&) = delete;
+	NoAllocationScope& operator=(const NoAllocationScope&) = delete;
+
+	void check();
+
+	// counts the calling thread's allocations into scope while it lives
+	class Thread {
+	private:
+		std::atomic<size_t>* previous;
+		bool attached;
+
+	public:
+		explicit Thread(NoAllocationScope& scope);
+		~Thread();
+	};
+
+	// called by the counting operator new
+	static void countAllocation();
+};
+
+#endif
@@ -1,10 +1,17 @@
 #include "SimConfig.h"
+#include <filesystem>
 
 SimConfig::SimConfig(double x, double y, double z, double v0, double r0, double initialAngleRadians, double timeLimit, double dt, const size_t& totalUavs)
 	: x(x), y(y), z(z), v0(v0), r0(r0), initialAngleRadians(initialAngleRadians), timeLimit(timeLimit), dt(dt), totalUavs(totalUavs)
 {
 }
 
+std::string SimConfig::outputPath(const std::string& name) const {
+	if (outputDirectory.empty() || std::filesystem::path(name).is_absolute())
+		return name;
+	return (std::filesystem::path(outputDirectory) / name).string();
+}
+
 void SimConfig::showConfig() const {
 	std::cout << "Loaded Configuration:" << '\n';
 	std::cout << "Number of UAVs: " << this->totalUavs << '\n';
@@ -14,4 +21,37 @@ void SimConfig::showConfig() const {
 	std::cout << "Initial Azimuth: " << (this->initialAngleRadians * 180. / M_PI) << " degrees" << '\n';
 	std::cout << "Simulation Delta: " << this->dt << '\n';
 	std::cout << "Time Limit: " << this->timeLimit << '\n';
+	std::cout << "Engine: " << ((this->engine == FLEET) ? "fleet" : (this->engine == ANALYTIC) ? "analytic" : (this->engine == HEADING) ? "heading" : (this->engine == MULTIRATE) ? "multirate" : "objects") << '\n';
+	std::cout << "Threads: " << this->threads << '\n';
+	std::cout << "Output: " << ((this->output == TEXT) ? "text" : (this->output == ASYNC_TEXT) ? "async" : "none") << '\n';
+	if (this->binaryOutput != BINARY_NONE)
+		std::cout << "Binary Output: " << this->binaryFile << '\n';
+	if (this->outputTolerance > 0.)
+		std::cout << "Output: adaptive, tolerance " << this->outputTolerance << '\n';
+	else if (this->outputInterval > 0.)
+		std::cout << "Output: every " << this->outputInterval << " seconds" << '\n';
+	else if (this->outputStride > 1)
+		std::cout << "Output: every " << this->outputStride << " ticks" << '\n';
+	if (this->commandInput == STREAM)
+		std::cout << "Commands: streamed, window " << this->commandWindow << '\n';
+	if (this->realTimeSpeed > 0.)
+		std::cout << "Real time: x" << this->realTimeSpeed << ((this->dropLateOutput) ? ", late ticks are not written" : "") << '\n';
+	if (!this->commandPipe.empty())
+		std::cout << "Command pipe: " << this->commandPipe << '\n';
+	if (this->commandQueue > 0)
+		std::cout << "Command queue: " << this->commandQueue << " entries" << '\n';
+	if (this->separation > 0.)
+		std::cout << "Separation: " << this->separation << ", conflicts in " << this->conflictFile << '\n';
+	if (this->checkpointInterval > 0.)
+		std::cout << "Checkpoint: every " << this->checkpointInterval << " seconds to " << this->checkpointFile << '\n';
+	if (!this->resumeFrom.empty())
+		std::cout << "Resume from: " << this->resumeFrom << '\n';
+	if (!this->outputDirectory.empty())
+		std::cout << "Output directory: " << this->outputDirectory << '\n';
+	if (this->arena)
+		std::cout << "Arena: on" << '\n';
+	if (!this->commandCache.empty())
+		std::cout << "Command cache: " << this->commandCache << '\n';
+	if (!this->fleet.empty())
+		std::cout << "Fleet: " << this->fleet << '\n';
 }
\ No newline at end of file
@@ -4,10 +4,61 @@
 
 // defines the configuration object for the current simulation
 class SimConfig {
+public:
+	// how the UAVs are advanced each tick (optional "Engine" key)
+	enum Engine {
+		OBJECTS, // a vector of UAV objects (default)
+		FLEET,   // structure-of-arrays UavFleet with batch kernels
+		ANALYTIC, // event-driven AnalyticFleet, closed-form straight / circular segments
+		HEADING,  // structure-of-arrays HeadingFleet, heading kept as a unit vector (no trig per tick)
+		MULTIRATE // MultiRateFleet, UAV objects stepping in closed form between flight state changes
+	};
+	// where the UAV samples go (optional "Output" key)
+	enum Output {
+		TEXT,      // UAV<n>.txt written through std::ofstream on the tick thread
+		ASYNC_TEXT, // same files, formatted and written by a background thread (default)
+		NO_TEXT     // no text files (e.g. binary output only)
+	};
+	// optional columnar binary file next to the text output ("BinaryOutput" / "BinaryFile" keys)
+	enum BinaryOutput {
+		BINARY_NONE, BINARY_F64, BINARY_F32, BINARY_DELTA32
+	};
+	// how the commands file is read (optional "CommandInput" / "CommandWindow" keys)
+	enum CommandInput {
+		EAGER,  // loaded and sorted before the run, any order (default)
+		STREAM  // read during the run, has to be sorted up to commandWindow lines
+	};
 private:
 	double x, y, z, v0, r0, initialAngleRadians, timeLimit, dt;
 	size_t totalUavs;
-
+	Engine engine = OBJECTS;
+	size_t threads = 1; // worker threads for the tick loop (optional "Threads" key)
+	Output output = ASYNC_TEXT;
+	BinaryOutput binaryOutput = BINARY_NONE;
+	std::string binaryFile = "Trajectories.uavtrj";
+	// output decimation (see OutputDecimator)
+	size_t outputStride = 1;
+	double outputInterval = 0.;
+	double outputTolerance = 0.;
+	CommandInput commandInput = EAGER;
+	size_t commandWindow = 4096;
+	std::string profileFile; // JSON profile of the run, empty = summary on stdout (UAV_PROFILE builds only)
+	// paced execution (see TickPacer): sim seconds per wall second, 0 = as fast as possible
+	double realTimeSpeed = 0.;
+	bool dropLateOutput = false;
+	std::string commandPipe; // named pipe for commands injected during the run (see PipeCommandSource)
+	size_t commandQueue = 0; // capacity of the queue for commands pushed by other threads (see QueueCommandSource), 0 = none
+	// separation check (see ConflictDetector), 0 = off
+	double separation = 0.;
+	std::string conflictFile = "Conflicts.txt";
+	// checkpoint / restart (see Checkpointer): sim seconds between checkpoints, 0 = off
+	double checkpointInterval = 0.;
+	std::string checkpointFile = "Simulation.uavckp";
+	std::string resumeFrom; // checkpoint to continue from, empty = start at time 0
+	std::string outputDirectory; // where every output file goes, empty = working directory
+	bool arena = false; // allocation-free tick loop, state in one SimArena (see Simulation::makeArena)
+	std::string commandCache; // binary cache of the sorted commands (CommandCache.h), empty = parse every run
+	std::string fleet; // manifest of airframe types and initial states (FleetManifest.h), empty = all UAVs alike
 
 public:
 
@@ -41,6 +92,94 @@ public:
 	size_t getTotalUavs() { return totalUavs; }
 	size_t getTotalUavs() const { return totalUavs; }
 
+	Engine getEngine() { return engine; }
+	Engine getEngine() const { return engine; }
+	void setEngine(const Engine engine) { this->engine = engine; }
+
+	size_t getThreads() { return threads; }
+	size_t getThreads() const { return threads; }
+	void setThreads(const size_t threads) { this->threads = (threads == 0) ? 1 : threads; }
+
+	Output getOutput() { return output; }
+	Output getOutput() const { return output; }
+	void setOutput(const Output output) { this->output = output; }
+
+	BinaryOutput getBinaryOutput() { return binaryOutput; }
+	BinaryOutput getBinaryOutput() const { return binaryOutput; }
+	void setBinaryOutput(const BinaryOutput binaryOutput) { this->binaryOutput = binaryOutput; }
+
+	const std::string& getBinaryFile() const { return binaryFile; }
+	void setBinaryFile(const std::string& binaryFile) { this->binaryFile = binaryFile; }
+
+	size_t getOutputStride() { return outputStride; }
+	size_t getOutputStride() const { return outputStride; }
+	void setOutputStride(const size_t outputStride) { this->outputStride = (outputStride == 0) ? 1 : outputStride; }
+
+	double getOutputInterval() { return outputInterval; }
+	double getOutputInterval() const { return outputInterval; }
+	void setOutputInterval(const double outputInterval) { this->outputInterval = outputInterval; }
+
+	double getOutputTolerance() { return outputTolerance; }
+	double getOutputTolerance() const { return outputTolerance; }
+	void setOutputTolerance(const double outputTolerance) { this->outputTolerance = outputTolerance; }
+
+	CommandInput getCommandInput() { return commandInput; }
+	CommandInput getCommandInput() const { return commandInput; }
+	void setCommandInput(const CommandInput commandInput) { this->commandInput = commandInput; }
+
+	size_t getCommandWindow() { return commandWindow; }
+	size_t getCommandWindow() const { return commandWindow; }
+	void setCommandWindow(const size_t commandWindow) { this->commandWindow = (commandWindow == 0) ? 1 : commandWindow; }
+
+	const std::string& getProfileFile() const { return profileFile; }
+	void setProfileFile(const std::string& profileFile) { this->profileFile = profileFile; }
+
+	double getRealTimeSpeed() { return realTimeSpeed; }
+	double getRealTimeSpeed() const { return realTimeSpeed; }
+	void setRealTimeSpeed(const double realTimeSpeed) { this->realTimeSpeed = (realTimeSpeed > 0.) ? realTimeSpeed : 0.; }
+
+	bool getDropLateOutput() { return dropLateOutput; }
+	bool getDropLateOutput() const { return dropLateOutput; }
+	void setDropLateOutput(const bool dropLateOutput) { this->dropLateOutput = dropLateOutput; }
+
+	const std::string& getCommandPipe() const { return commandPipe; }
+	void setCommandPipe(const std::string& commandPipe) { this->commandPipe = commandPipe; }
+
+	size_t getCommandQueue() const { return commandQueue; }
+	void setCommandQueue(const size_t commandQueue) { this->commandQueue = commandQueue; }
+
+	double getSeparation() { return separation; }
+	double getSeparation() const { return separation; }
+	void setSeparation(const double separation) { this->separation = (separation > 0.) ? separation : 0.; }
+
+	const std::string& getConflictFile() const { return conflictFile; }
+	void setConflictFile(const std::string& conflictFile) { this->conflictFile = conflictFile; }
+
+	double getCheckpointInterval() { return checkpointInterval; }
+	double getCheckpointInterval() const { return checkpointInterval; }
+	void setCheckpointInterval(const double checkpointInterval) { this->checkpointInterval = (checkpointInterval > 0.) ? checkpointInterval : 0.; }
+
+	const std::string& getCheckpointFile() const { return checkpointFile; }
+	void setCheckpointFile(const std::string& checkpointFile) { this->checkpointFile = checkpointFile; }
+
+	const std::string& getResumeFrom() const { return resumeFrom; }
+	void setResumeFrom(const std::string& resumeFrom) { this->resumeFrom = resumeFrom; }
+
+	const std::string& getOutputDirectory() const { return outputDirectory; }
+	void setOutputDirectory(const std::string& outputDirectory) { this->outputDirectory = outputDirectory; }
+
+	bool getArena() { return arena; }
+	bool getArena() const { return arena; }
+	void setArena(const bool arena) { this->arena = arena; }
+
+	const std::string& getCommandCache() const { return commandCache; }
+	void setCommandCache(const std::string& commandCache) { this->commandCache = commandCache; }
+
+	const std::string& getFleet() const { return fleet; }
+	void setFleet(const std::string& fleet) { this->fleet = fleet; }
+
+	// an output file name inside the output directory (absolute names stay as they are)
+	std::string outputPath(const std::string& name) const;
 
 
 	SimConfig() = default;
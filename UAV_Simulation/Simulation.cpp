@@ -1,90 +1,250 @@
 #include "Simulation.h"
+#include "TextTrajectorySink.h"
+#include "AsyncTextTrajectorySink.h"
+#include "BinaryTrajectorySink.h"
+#include "MultiTrajectorySink.h"
+#include "OutputDecimator.h"
+#include "VectorCommandSource.h"
+#include "StreamingCommandSource.h"
+#include "PipeCommandSource.h"
+#include "QueueCommandSource.h"
+#include "CommandCache.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+
+
+std::vector<Command> Simulation::readCommandsFromFile(const std::string& filename, const size_t uavCount) {
+    // the file is mapped and parsed in place
+    const MappedFile file(filename);
+    const char* first = reinterpret_cast<const char*>(file.begin());
+    return parseCommands(first, first + file.size(), filename, uavCount);
+}
 
+std::vector<Command> Simulation::parseCommands(const char* p, const char* const end, const std::string& filename, const size_t uavCount) {
+    // with std::from_chars, one "time uavNum x y" line at a time
+    std::vector<Command> commands;
+    commands.reserve(std::count(p, end, '\n') + 1);
+    size_t lineNumber = 0;
+    while (p < end) {
+        const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+        const char* last = newline ? newline : end;
+        lineNumber++;
+        if (!std::all_of(p, last, [](const char c) { return c == ' ' || c == '\t' || c == '\r'; })) {
+            Command command;
+            if (!StreamingCommandSource::parseLine(p, last, command)) {
+                throw std::runtime_error("Invalid line format in file " + filename + " at line " + std::to_string(lineNumber));
+            }
+            if (command.getUavNum() >= uavCount) {
+                throw std::runtime_error("Command for UAV " + std::to_string(command.getUavNum()) + " in file " + filename +
+                    " at line " + std::to_string(lineNumber) + ", but N_uav = " + std::to_string(uavCount));
+            }
+            commands.push_back(command);
+        }
+        p = last + 1;
+    }
+    return commands;
+}
 
-std::vector<Command> Simulation::readCommandsFromFile(const std::string& filename) {
+std::vector<Command> Simulation::loadCommandsVectorFromFileSorted(const std::string& filename, const size_t uavCount,
+    const std::string& cacheFile) {
     std::vector<Command> commands;
-    commands.reserve(10); // avoid the extra initial allocations
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        throw std::runtime_error("Unable to open file: " + filename);
+    uint64_t sourceSize = 0;
+    int64_t sourceModified = 0;
+    if (!cacheFile.empty()) {
+        if (CommandCache::read(cacheFile, filename, uavCount, commands))
+            return commands;
+        CommandCache::stamp(filename, sourceSize, sourceModified); // before parsing, a later change makes the cache stale
     }
+    commands = readCommandsFromFile(filename, uavCount);
+    // latest first, commands with the same time in reverse file order - popping from the back gives file order
+    std::reverse(commands.begin(), commands.end());
+    std::stable_sort(commands.begin(), commands.end(), Command::later);
+    if (!cacheFile.empty())
+        CommandCache::write(cacheFile, sourceSize, sourceModified, commands);
+    return commands;
+}
 
-    std::string line;
-    while (std::getline(file, line)) {
-        //std::cout << " Line read: " << line << "\n";
+std::unique_ptr<CommandSource> Simulation::makeCommandSource(const std::string& filename) {
+    std::unique_ptr<CommandSource> source;
+    if (config.getCommandInput() == SimConfig::CommandInput::STREAM)
+        source = std::make_unique<StreamingCommandSource>(filename, config.getCommandWindow(), config.getTotalUavs());
+    else if (config.getArena()) {
+        // the arena is sized once the command count is known, and the commands move into it
+        const std::vector<Command> sorted = loadCommandsVectorFromFileSorted(filename, config.getTotalUavs(), config.getCommandCache());
+        arena = makeArena(sorted.size());
+        source = std::make_unique<VectorCommandSource>(sorted, arena.get());
+    }
+    else
+        source = std::make_unique<VectorCommandSource>(loadCommandsVectorFromFileSorted(filename, config.getTotalUavs(), config.getCommandCache()));
+    if (!config.getCommandPipe().empty())
+        source = std::make_unique<PipeCommandSource>(std::move(source), config.getCommandPipe(), config.getTotalUavs());
+    return addCommandQueue(std::move(source));
+}
 
-        std::istringstream iss(line);
-        double time, x, y;
-        int uavNum;
+std::unique_ptr<CommandSource> Simulation::addCommandQueue(std::unique_ptr<CommandSource> source) {
+    if (config.getCommandQueue() == 0)
+        return source;
+    commandQueue = std::make_unique<CommandQueue>(config.getCommandQueue());
+    return std::make_unique<QueueCommandSource>(std::move(source), *commandQueue, config.getTotalUavs());
+}
 
-        if (!(iss >> time >> uavNum >> x >> y)) {
-            throw std::runtime_error("Invalid line format in file");
-        }
+std::unique_ptr<SimArena> Simulation::makeArena(const size_t commandCount) const {
+    if (!config.getArena())
+        return nullptr;
+    const size_t uavCount = config.getTotalUavs();
+    size_t bytes = uavCount * sizeof(UAV) + manifest.getTypeCount() * sizeof(UAV::Airframe) + commandCount * sizeof(Command) +
+        CommandScheduler::memoryBytes(uavCount) + StateBuckets::memoryBytes(uavCount);
+    if (config.getOutput() == SimConfig::Output::ASYNC_TEXT)
+        bytes += AsyncTextTrajectorySink::memoryBytes(uavCount);
+    return std::make_unique<SimArena>(bytes + 4096); // + alignment of each block
+}
+
+std::pmr::memory_resource* Simulation::memory() const {
+    return arena ? arena.get() : std::pmr::get_default_resource();
+}
 
-        Command cmd(x, y, time, uavNum);
-        commands.push_back(cmd);
+// Function to trim whitespace from a string (a view into it, nothing is copied)
+std::string_view Simulation::trim(const std::string_view s) {
+    const size_t start = s.find_first_not_of(" \t\r");
+    const size_t end = s.find_last_not_of(" \t\r");
+    return (start == std::string_view::npos) ? std::string_view() : s.substr(start, end - start + 1);
+}
+
+// Function to read a number from a string with std::from_chars, all of it has to be the number
+template <typename Number>
+static Number readNumber(std::string_view s) {
+    if (!s.empty() && s[0] == '+')
+        s.remove_prefix(1);
+    Number value;
+    const std::from_chars_result r = std::from_chars(s.data(), s.data() + s.size(), value);
+    if (r.ec != std::errc() || r.ptr != s.data() + s.size()) {
+        throw std::runtime_error("not a valid number: " + std::string(s));
     }
+    return value;
+}
 
-    file.close();
-    return commands;
+// Function to read a double value from a string
+const double Simulation::readdouble(const std::string_view s) {
+    return readNumber<double>(trim(s));
 }
 
-std::vector<Command> Simulation::loadCommandsVectorFromFileSorted(const std::string& filename) {
-    std::vector<Command> commands = readCommandsFromFile(filename);
-    std::sort(commands.begin(), commands.end());
-    return commands;
+// Function to read a count (non-negative integer) from a string
+const size_t Simulation::readsize(const std::string_view s) {
+    return readNumber<size_t>(trim(s));
+}
 
+// Function to read an engine name ("objects" / "fleet" / "analytic" / "heading" / "multirate") from a string
+const SimConfig::Engine Simulation::readEngine(const std::string_view s) {
+    const std::string_view name = trim(s);
+    if (name == "objects") return SimConfig::Engine::OBJECTS;
+    if (name == "fleet") return SimConfig::Engine::FLEET;
+    if (name == "analytic") return SimConfig::Engine::ANALYTIC;
+    if (name == "heading") return SimConfig::Engine::HEADING;
+    if (name == "multirate") return SimConfig::Engine::MULTIRATE;
+    throw std::runtime_error("Unknown engine: " + std::string(name));
 }
 
-// Function to trim whitespace from a string
-const std::string Simulation::trim(const std::string& s) {
-    size_t start = s.find_first_not_of(" \t");
-    size_t end = s.find_last_not_of(" \t");
-    return (start == std::string::npos || end == std::string::npos) ? "" : s.substr(start, end - start + 1);
+// Function to read an output kind ("text" / "async") from a string
+const SimConfig::Output Simulation::readOutput(const std::string_view s) {
+    const std::string_view name = trim(s);
+    if (name == "text") return SimConfig::Output::TEXT;
+    if (name == "async") return SimConfig::Output::ASYNC_TEXT;
+    if (name == "none") return SimConfig::Output::NO_TEXT;
+    throw std::runtime_error("Unknown output: " + std::string(name));
 }
 
-// Function to read a double value from a string
-const double Simulation::readdouble(const std::string& s) {
-    std::istringstream iss(trim(s));
-    double value;
-    iss >> value;
-    return value;
+// Function to read a binary output encoding ("none" / "f64" / "f32" / "delta") from a string
+const SimConfig::BinaryOutput Simulation::readBinaryOutput(const std::string_view s) {
+    const std::string_view name = trim(s);
+    if (name == "none") return SimConfig::BinaryOutput::BINARY_NONE;
+    if (name == "f64") return SimConfig::BinaryOutput::BINARY_F64;
+    if (name == "f32") return SimConfig::BinaryOutput::BINARY_F32;
+    if (name == "delta") return SimConfig::BinaryOutput::BINARY_DELTA32;
+    throw std::runtime_error("Unknown binary output: " + std::string(name));
 }
 
-// Function to read an int value from a string
-const int Simulation::readint(const std::string& s) {
-    std::istringstream iss(trim(s));
-    int value;
-    iss >> value;
-    return value;
+// Function to read a command input mode ("eager" / "stream") from a string
+const SimConfig::CommandInput Simulation::readCommandInput(const std::string_view s) {
+    const std::string_view name = trim(s);
+    if (name == "eager") return SimConfig::CommandInput::EAGER;
+    if (name == "stream") return SimConfig::CommandInput::STREAM;
+    throw std::runtime_error("Unknown command input: " + std::string(name));
+}
+
+// Function to read what happens to late ticks' samples in real time mode ("keep" / "drop"), true for drop
+const bool Simulation::readLateOutput(const std::string_view s) {
+    const std::string_view name = trim(s);
+    if (name == "keep") return false;
+    if (name == "drop") return true;
+    throw std::runtime_error("Unknown late output: " + std::string(name));
+}
+
+// Function to read the arena switch ("off" / "on") from a string
+const bool Simulation::readArena(const std::string_view s) {
+    const std::string_view name = trim(s);
+    if (name == "off") return false;
+    if (name == "on") return true;
+    throw std::runtime_error("Unknown arena setting: " + std::string(name));
 }
 
 SimConfig Simulation::loadConfig(std::string filename) {
-    // default values
-    double x = 0.0, y = 0.0, z = 0.0, dt = 0.0, timeLimit = 0.0, radius = 0.0, velocity = 0.0, azimuth = 0.0;
-    size_t nUavs = 0;
     std::ifstream configFile(filename);
 
     if (!configFile.is_open()) {
         throw std::runtime_error("Failed to open " + filename);
     }
+    return parseConfig(configFile);
+}
 
-    std::string line;
+SimConfig Simulation::parseConfig(std::istream& configFile) {
+    // default values
+    double x = 0.0, y = 0.0, z = 0.0, dt = 0.0, timeLimit = 0.0, radius = 0.0, velocity = 0.0, azimuth = 0.0;
+    size_t nUavs = 0;
+    SimConfig::Engine engine = SimConfig::Engine::OBJECTS;
+    size_t threads = 1;
+    SimConfig::Output output = SimConfig::Output::ASYNC_TEXT;
+    SimConfig::BinaryOutput binaryOutput = SimConfig::BinaryOutput::BINARY_NONE;
+    std::string binaryFile;
+    size_t outputStride = 1;
+    double outputInterval = 0., outputTolerance = 0.;
+    SimConfig::CommandInput commandInput = SimConfig::CommandInput::EAGER;
+    size_t commandWindow = 4096;
+    std::string profileFile;
+    double realTimeSpeed = 0.;
+    bool dropLateOutput = false;
+    std::string commandPipe;
+    size_t commandQueue = 0;
+    double separation = 0.;
+    std::string conflictFile;
+    double checkpointInterval = 0.;
+    std::string checkpointFile, resumeFrom;
+    std::string outputDirectory;
+    bool arena = false;
+
+    std::string commandCache;
+    std::string fleet;
+    std::string text;
+    size_t lineNumber = 0;
     bool allFieldsFound = true;
 
-    while (std::getline(configFile, line)) {
-        line = trim(line);
+    while (std::getline(configFile, text)) {
+        lineNumber++;
+        const std::string_view line = trim(text);
         if (line.empty() || line[0] == '#') continue;
 
         size_t equalsPos = line.find('=');
-        if (equalsPos == std::string::npos) continue;
+        if (equalsPos == std::string_view::npos) continue;
 
-        const std::string key = trim(line.substr(0, equalsPos));
-        const std::string value = trim(line.substr(equalsPos + 1));
+        const std::string_view key = trim(line.substr(0, equalsPos));
+        const std::string_view value = trim(line.substr(equalsPos + 1));
 
         try {
             if (key == "Dt") dt = readdouble(value);
-            else if (key == "N_uav") nUavs = readint(value);
+            else if (key == "N_uav") nUavs = readsize(value);
             else if (key == "R") radius = readdouble(value);
             else if (key == "X0") x = readdouble(value);
             else if (key == "Y0") y = readdouble(value);
@@ -92,38 +252,94 @@ SimConfig Simulation::loadConfig(std::string filename) {
             else if (key == "V0") velocity = readdouble(value);
             else if (key == "Az") azimuth = readdouble(value);
             else if (key == "TimeLim") timeLimit = readdouble(value);
+            // optional keys
+            else if (key == "Engine") engine = readEngine(value);
+            else if (key == "Threads") threads = readsize(value);
+            else if (key == "Output") output = readOutput(value);
+            else if (key == "BinaryOutput") binaryOutput = readBinaryOutput(value);
+            else if (key == "BinaryFile") binaryFile = std::string(value);
+            else if (key == "OutputStride") outputStride = readsize(value);
+            else if (key == "OutputInterval") outputInterval = readdouble(value);
+            else if (key == "OutputTolerance") outputTolerance = readdouble(value);
+            else if (key == "CommandInput") commandInput = readCommandInput(value);
+            else if (key == "CommandWindow") commandWindow = readsize(value);
+            else if (key == "ProfileFile") profileFile = std::string(value);
+            else if (key == "RealTime") realTimeSpeed = readdouble(value);
+            else if (key == "LateOutput") dropLateOutput = readLateOutput(value);
+            else if (key == "CommandPipe") commandPipe = std::string(value);
+            else if (key == "CommandQueue") commandQueue = readsize(value);
+            else if (key == "Separation") separation = readdouble(value);
+            else if (key == "ConflictFile") conflictFile = std::string(value);
+            else if (key == "CheckpointInterval") checkpointInterval = readdouble(value);
+            else if (key == "CheckpointFile") checkpointFile = std::string(value);
+            else if (key == "ResumeFrom") resumeFrom = std::string(value);
+            else if (key == "OutputDirectory") outputDirectory = std::string(value);
+            else if (key == "Arena") arena = readArena(value);
+            else if (key == "CommandCache") commandCache = std::string(value);
+            else if (key == "Fleet") fleet = std::string(value);
             else {
                 // Unknown key
-                throw std::exception("Invalid key!");
+                throw std::runtime_error("unknown key");
             }
         }
-        catch (const std::exception&) {
-            std::cerr << "Warning: Failed to parse value for '" << key << "'. Skipping." << '\n';
+        catch (const std::exception& e) {
+            std::cerr << "Warning: Failed to parse value for '" << key << "' at line " << lineNumber << " (" << e.what() << "). Skipping." << '\n';
             allFieldsFound = false;
         }
     }
 
-    configFile.close();
-
     // Check if all required fields were found
     if (!allFieldsFound) {
         throw std::runtime_error("Not all required configuration fields were found or parsed correctly.");
     }
 
+    // values no run can start with (commands are checked against N_uav when they are loaded)
+    if (nUavs == 0 || !(dt > 0.) || !(radius > 0.) || !(timeLimit >= 0.)) {
+        throw std::runtime_error("N_uav, Dt and R must be positive and TimeLim must not be negative");
+    }
+
     // init config object
-    return SimConfig(x,y,z,velocity, radius, azimuth * M_PI / 180., timeLimit, dt, nUavs);
+    SimConfig loaded(x,y,z,velocity, radius, azimuth * M_PI / 180., timeLimit, dt, nUavs);
+    loaded.setEngine(engine);
+    loaded.setThreads(threads);
+    loaded.setOutput(output);
+    loaded.setBinaryOutput(binaryOutput);
+    if (!binaryFile.empty())
+        loaded.setBinaryFile(binaryFile);
+    loaded.setOutputStride(outputStride);
+    loaded.setOutputInterval(outputInterval);
+    loaded.setOutputTolerance(outputTolerance);
+    loaded.setCommandInput(commandInput);
+    loaded.setCommandWindow(commandWindow);
+    loaded.setProfileFile(profileFile);
+    loaded.setRealTimeSpeed(realTimeSpeed);
+    loaded.setDropLateOutput(dropLateOutput);
+    loaded.setCommandPipe(commandPipe);
+    loaded.setCommandQueue(commandQueue);
+    loaded.setSeparation(separation);
+    if (!conflictFile.empty())
+        loaded.setConflictFile(conflictFile);
+    loaded.setCheckpointInterval(checkpointInterval);
+    if (!checkpointFile.empty())
+        loaded.setCheckpointFile(checkpointFile);
+    loaded.setResumeFrom(resumeFrom);
+    loaded.setOutputDirectory(outputDirectory);
+    loaded.setArena(arena);
+    loaded.setCommandCache(commandCache);
+    loaded.setFleet(fleet);
+    return loaded;
 
 }
 
 
 void Simulation::verboseShowRunInfo()
 {
-    for (const auto& c : commands) {
-        std::cout << "command params (x,y,time,uav): " << c.getX() << ", " << c.getY() << ", " << c.getTime() << ", " << c.getUavNum() << "\n";
-    }
+    commands->show();
     int n = 0; // dummy variable for storing UAV number
     // Print loaded configuration
     config.showConfig();
+    if (!config.getFleet().empty())
+        manifest.show();
 
     // Print initial UAV states
     std::cout << "\nInitial UAV States:" << '\n';
@@ -134,71 +350,457 @@ void Simulation::verboseShowRunInfo()
     }
 }
 
-const std::vector<UAV> Simulation::initializeUAVs(const SimConfig& config) {
-    std::vector<UAV> uavs;
-    //uavs.reserve(config.getTotalUavs());
-    for (size_t i = 0; i < config.getTotalUavs(); ++i) {
-        uavs.emplace_back(i, config.getX(), config.getY(), config.getAngleRad(), config.getV0(), config.getR0(), config.getDt());
+std::pmr::vector<UAV::Airframe> Simulation::initializeAirframes() {
+    std::pmr::vector<UAV::Airframe> airframes(memory());
+    airframes.reserve(manifest.getTypeCount());
+    for (size_t t = 0; t < manifest.getTypeCount(); ++t) {
+        airframes.emplace_back(manifest.getType(t).velocity, manifest.getType(t).turnRadius, config.getDt());
+    }
+    return airframes;
+}
+
+std::pmr::vector<UAV> Simulation::initializeUAVs() {
+    std::pmr::vector<UAV> uavs(memory());
+    uavs.reserve(manifest.size());
+    for (size_t i = 0; i < manifest.size(); ++i) {
+        const FleetManifest::Placement& start = manifest.getPlacement(i);
+        uavs.emplace_back(i, start.x, start.y, start.radianAngle, airframes[start.type]);
     }
     return uavs;
 }
 
 
-void Simulation::run() {
+// hand every command due at the tick starting at currentTime to apply (at most one per UAV, see CommandScheduler)
+template <typename ApplyCommand>
+static void dispatchDueCommands(CommandScheduler& scheduler, const double currentTime, ApplyCommand apply) {
+    PROFILE_PHASE(PHASE_COMMANDS);
+    const std::pmr::vector<Command>& due = scheduler.collect(currentTime);
+    PROFILE_COUNT(COUNT_COMMANDS, due.size());
+    for (const Command& command : due) {
+        if (_VERBOSE) {
+            // print command
+            std::cout << "Executing command: " << command.getTime() << ", x,y:" << command.getX() << ", " <<
+                command.getY() << ". Command for UAV num: " << command.getUavNum() << "\n";
+        }
+        // turning logic here - begins here and then goes through stages as described below
+        apply(command);
+    }
+}
 
-    std::vector<std::ofstream> streams(config.getTotalUavs());
-    // initialize file streams and open them
-    for (size_t i = 0; i < config.getTotalUavs(); i++) {
-        std::string fileName = "UAV" + std::to_string(i) + ".txt";
-        streams[i].open(fileName.c_str());
+void Simulation::runObjects(TrajectorySink& sink, TickPacer& pacer, ConflictDetector* conflicts, RunCheckpoints& checkpoints) {
+    OutputDecimator decimator(config, manifest);
+    if (checkpoints.resume) {
+        for (auto& uav : uavs)
+            uav.restore(*checkpoints.resume);
+        decimator.restore(*checkpoints.resume);
     }
-    if (_VERBOSE)
-        std::cout << "\n - - - Simulation begins - - - \n";
-    for (double currentTime = 0.; currentTime < config.getTimeLimit(); currentTime += config.getDt()) {
+    StateBuckets buckets(uavs.data(), 0, uavs.size(), memory());
+    size_t tick = checkpoints.startTick;
+    NoAllocationScope noAllocations(arena != nullptr);
+    for (double currentTime = checkpoints.startTime; currentTime < config.getTimeLimit(); currentTime += config.getDt(), tick++) {
+        pacer.waitForTick(tick);
+        PROFILE_TICK();
+        if (checkpoints.writer.due(currentTime)) {
+            saveCheckpoint(checkpoints.writer, tick, currentTime, sink, conflicts, decimator, [this](CheckpointBuffer& out) {
+                for (const auto& uav : uavs)
+                    uav.save(out);
+            });
+        }
         // before performing each tick, fetch commands
-        // store last command to avoid calling duplicates (in case these exist in "queue")
-        Command lastCommand = { -1,-1,-1,0 };
-        // check if there are commands to perform, if yes, check if time for first command has arrived.
-        while (commands.size() && currentTime >= commands.back().getTime()) {
-            // pop command
-            const Command command = commands.back();
-            const size_t uavNum = command.getUavNum();
-            commands.pop_back();  // assuming there are thousands of commands, we remove them during simulation to maintain low memory footprint
-            if (command == lastCommand)
-                continue;   // ignore duplicate commands
-            if (_VERBOSE) {
-                // print command
-                std::cout << "Executing command: " << command.getTime() << ", x,y:" << command.getX() << ", " <<
-                    command.getY() << ". Command for UAV num: " << command.getUavNum() << "\n";
+        dispatchDueCommands(scheduler, currentTime, [this, &buckets](const Command& command) {
+            uavs[command.getUavNum()].acceptCommand(command);
+            buckets.moveTo(command.getUavNum(), uavs[command.getUavNum()].getState());
+        });
+        // perform tick logic for each UAV, one state bucket at a time
+        {
+            PROFILE_PHASE(PHASE_FLIGHT);
+            buckets.flightStep(uavs.data());
+        }
+        if (conflicts) {
+            PROFILE_PHASE(PHASE_CONFLICTS);
+            for (const auto& uav : uavs)
+                conflicts->setPosition(uav.getUavNum(), uav.getX(), uav.getY());
+            conflicts->endTick(currentTime);
+        }
+        PROFILE_PHASE(PHASE_OUTPUT);
+        const bool lastTick = !(currentTime + config.getDt() < config.getTimeLimit());
+        if (!pacer.dropsOutput(tick, lastTick) && decimator.tickWanted(tick, currentTime, lastTick)) {
+            for (const auto& uav : uavs) {
+                if (decimator.sampleWanted(uav.getUavNum(), tick, currentTime, lastTick,
+                    uav.getX(), uav.getY(), uav.getAngleRad(), uav.getState(), uav.isClockwise()))
+                    sink.record(uav.getUavNum(), currentTime, uav.getX(), uav.getY(), uav.getAngleRad());
             }
-            // turning logic here - begins here and then goes through stages as described below
-            uavs[uavNum].acceptCommand(command);
-            // store current command
-            lastCommand = command;
         }
-        // perform tick logic for each UAV
-        for (auto& uav : uavs) {
-            // while is used since we don't know for a fact there is always just one command per UAV per unit of time.
-            uav.flightStep(currentTime);
-            // Write current stats to file (we only need degrees here, so we convert here)
-            streams[uav.getUavNum()] << std::fixed << std::setprecision(2) <<
-                currentTime << " " << uav.getX() << " " << uav.getY() << " " << (uav.getAngleRad() * 180. / M_PI) << '\n';
+        sink.endTick();
+        noAllocations.check();
+    }
+}
+
+// same loop as runObjects, with uavs split into one contiguous shard per worker.
+// commands are dispatched on this thread before the workers start, and each UAV (and its stream)
+// is only ever touched by the worker owning its shard, so the output does not depend on the thread count.
+// (each worker writes its own shard, so for the profiler the flight phase includes the output here)
+void Simulation::runObjectsParallel(TrajectorySink& sink, TickPacer& pacer, ConflictDetector* conflicts, RunCheckpoints& checkpoints) {
+    TickWorkerPool pool(std::min(config.getThreads(), uavs.size()));
+    OutputDecimator decimator(config, manifest);
+    if (checkpoints.resume) {
+        for (auto& uav : uavs)
+            uav.restore(*checkpoints.resume);
+        decimator.restore(*checkpoints.resume);
+    }
+    // state buckets per shard, each only touched by its worker (and by command dispatch between ticks)
+    std::vector<StateBuckets> buckets;
+    buckets.reserve(pool.size());
+    for (size_t worker = 0; worker < pool.size(); worker++) {
+        const size_t begin = TickWorkerPool::shardBegin(worker, pool.size(), uavs.size());
+        buckets.emplace_back(uavs.data(), begin, TickWorkerPool::shardEnd(worker, pool.size(), uavs.size()) - begin, memory());
+    }
+    size_t tick = checkpoints.startTick;
+    double currentTime = checkpoints.startTime;
+    bool lastTick = false, writeTick = true;
+    std::optional<NoAllocationScope> noAllocations; // opened once stepShard is built, which allocates
+    const std::function<void(const size_t)> stepShard = [&](const size_t worker) {
+        NoAllocationScope::Thread countedHere(*noAllocations);
+        buckets[worker].flightStep(uavs.data());
+        if (!writeTick)
+            return;
+        const size_t end = TickWorkerPool::shardEnd(worker, pool.size(), uavs.size());
+        for (size_t i = TickWorkerPool::shardBegin(worker, pool.size(), uavs.size()); i < end; i++) {
+            const UAV& uav = uavs[i];
+            if (decimator.sampleWanted(uav.getUavNum(), tick, currentTime, lastTick,
+                uav.getX(), uav.getY(), uav.getAngleRad(), uav.getState(), uav.isClockwise()))
+                sink.record(uav.getUavNum(), currentTime, uav.getX(), uav.getY(), uav.getAngleRad());
+        }
+    };
+    noAllocations.emplace(arena != nullptr);
+    for (; currentTime < config.getTimeLimit(); currentTime += config.getDt(), tick++) {
+        pacer.waitForTick(tick);
+        PROFILE_TICK();
+        // the workers are idle between ticks, the snapshot sees every UAV at rest
+        if (checkpoints.writer.due(currentTime)) {
+            saveCheckpoint(checkpoints.writer, tick, currentTime, sink, conflicts, decimator, [this](CheckpointBuffer& out) {
+                for (const auto& uav : uavs)
+                    uav.save(out);
+            });
+        }
+        dispatchDueCommands(scheduler, currentTime, [this, &buckets, &pool](const Command& command) {
+            const size_t i = command.getUavNum();
+            uavs[i].acceptCommand(command);
+            buckets[TickWorkerPool::shardOf(i, pool.size(), uavs.size())].moveTo(i, uavs[i].getState());
+        });
+        lastTick = !(currentTime + config.getDt() < config.getTimeLimit());
+        writeTick = !pacer.dropsOutput(tick, lastTick) && decimator.tickWanted(tick, currentTime, lastTick);
+        {
+            PROFILE_PHASE(PHASE_FLIGHT);
+            pool.runTick(stepShard);
+        }
+        if (conflicts) {
+            PROFILE_PHASE(PHASE_CONFLICTS);
+            for (const auto& uav : uavs)
+                conflicts->setPosition(uav.getUavNum(), uav.getX(), uav.getY());
+            conflicts->endTick(currentTime);
+        }
+        PROFILE_PHASE(PHASE_OUTPUT);
+        sink.endTick();
+        noAllocations->check();
+    }
+}
+
+template <typename Fleet>
+void Simulation::runFleet(TrajectorySink& sink, TickPacer& pacer, ConflictDetector* conflicts, RunCheckpoints& checkpoints) {
+    // the fleet takes over the UAV starting states
+    Fleet fleet(manifest, config.getDt());
+    OutputDecimator decimator(config, manifest);
+    if (checkpoints.resume) {
+        fleet.restore(*checkpoints.resume);
+        decimator.restore(*checkpoints.resume);
+    }
+    size_t tick = checkpoints.startTick;
+    for (double currentTime = checkpoints.startTime; currentTime < config.getTimeLimit(); currentTime += config.getDt(), tick++) {
+        pacer.waitForTick(tick);
+        PROFILE_TICK();
+        if (checkpoints.writer.due(currentTime)) {
+            saveCheckpoint(checkpoints.writer, tick, currentTime, sink, conflicts, decimator, [&fleet](CheckpointBuffer& out) {
+                fleet.save(out);
+            });
+        }
+        dispatchDueCommands(scheduler, currentTime, [&fleet](const Command& command) {
+            fleet.acceptCommand(command);
+        });
+        // one batch step for the whole fleet, then write
+        {
+            PROFILE_PHASE(PHASE_FLIGHT);
+            fleet.flightStep(currentTime);
+        }
+        if (conflicts) {
+            PROFILE_PHASE(PHASE_CONFLICTS);
+            for (size_t i = 0; i < fleet.size(); i++)
+                conflicts->setPosition(i, fleet.getX(i), fleet.getY(i));
+            conflicts->endTick(currentTime);
+        }
+        PROFILE_PHASE(PHASE_OUTPUT);
+        const bool lastTick = !(currentTime + config.getDt() < config.getTimeLimit());
+        if (!pacer.dropsOutput(tick, lastTick) && decimator.tickWanted(tick, currentTime, lastTick)) {
+            for (size_t i = 0; i < fleet.size(); i++) {
+                if (decimator.sampleWanted(i, tick, currentTime, lastTick,
+                    fleet.getX(i), fleet.getY(i), fleet.getAngleRad(i), fleet.getState(i), fleet.isClockwise(i)))
+                    sink.record(i, currentTime, fleet.getX(i), fleet.getY(i), fleet.getAngleRad(i));
+            }
+        }
+        sink.endTick();
+    }
+}
+
+// the tick loop only keeps the clock, dispatches commands and asks for samples - the UAVs themselves
+// are advanced from event to event, and only evaluated on ticks that are written, or on every tick
+// when the separation check is on (so for the profiler the flight work happens in the output phase)
+void Simulation::runAnalytic(TrajectorySink& sink, TickPacer& pacer, ConflictDetector* conflicts) {
+    AnalyticFleet fleet(manifest, config.getDt());
+    OutputDecimator decimator(config, manifest);
+    // with no output at all the tracks only advance for commands (and the separation check)
+    const bool writesSamples = config.getOutput() != SimConfig::Output::NO_TEXT || config.getBinaryOutput() != SimConfig::BinaryOutput::BINARY_NONE;
+    size_t tick = 0;
+    for (double currentTime = 0.; currentTime < config.getTimeLimit(); currentTime += config.getDt(), tick++) {
+        pacer.waitForTick(tick);
+        PROFILE_TICK();
+        dispatchDueCommands(scheduler, currentTime, [&fleet, currentTime](const Command& command) {
+            fleet.acceptCommand(command, currentTime);
+        });
+        PROFILE_PHASE(PHASE_OUTPUT);
+        const bool lastTick = !(currentTime + config.getDt() < config.getTimeLimit());
+        const bool writeTick = writesSamples && !pacer.dropsOutput(tick, lastTick) && decimator.tickWanted(tick, currentTime, lastTick);
+        if (writeTick || conflicts) {
+            // a tick's sample shows the UAV after its step, i.e. at the end of the tick
+            const double sampleTime = currentTime + config.getDt();
+            for (size_t i = 0; i < fleet.size(); i++) {
+                double x, y, angle;
+                UAV::State state;
+                bool clockwise;
+                fleet.sample(i, sampleTime, x, y, angle, state, clockwise);
+                if (conflicts)
+                    conflicts->setPosition(i, x, y);
+                if (writeTick && decimator.sampleWanted(i, tick, currentTime, lastTick, x, y, angle, state, clockwise))
+                    sink.record(i, currentTime, x, y, angle);
+            }
+        }
+        if (conflicts) {
+            PROFILE_PHASE(PHASE_CONFLICTS);
+            conflicts->endTick(currentTime);
         }
+        sink.endTick();
+    }
+}
 
+// the tick loop keeps the clock and asks for commands and samples, each UAV catches up with the tick
+// it is asked about in as few flight steps as it can (MultiRateFleet) - so, as for the analytic engine,
+// the flight work happens in the output phase for the profiler
+void Simulation::runMultiRate(TrajectorySink& sink, TickPacer& pacer, ConflictDetector* conflicts, RunCheckpoints& checkpoints) {
+    MultiRateFleet fleet(manifest, config.getDt());
+    OutputDecimator decimator(config, manifest);
+    // with no output at all the UAVs only catch up for commands (and the separation check / checkpoints)
+    const bool writesSamples = config.getOutput() != SimConfig::Output::NO_TEXT || config.getBinaryOutput() != SimConfig::BinaryOutput::BINARY_NONE;
+    if (checkpoints.resume) {
+        fleet.restore(*checkpoints.resume, checkpoints.startTick);
+        decimator.restore(*checkpoints.resume);
     }
-    // close files
-    for (auto& s : streams) {
-        if (s.is_open()) {
-            s.close();
+    size_t tick = checkpoints.startTick;
+    for (double currentTime = checkpoints.startTime; currentTime < config.getTimeLimit(); currentTime += config.getDt(), tick++) {
+        pacer.waitForTick(tick);
+        PROFILE_TICK();
+        if (checkpoints.writer.due(currentTime)) {
+            saveCheckpoint(checkpoints.writer, tick, currentTime, sink, conflicts, decimator, [&fleet, tick](CheckpointBuffer& out) {
+                fleet.save(out, tick);
+            });
+        }
+        dispatchDueCommands(scheduler, currentTime, [&fleet, tick](const Command& command) {
+            fleet.acceptCommand(command, tick);
+        });
+        PROFILE_PHASE(PHASE_OUTPUT);
+        const bool lastTick = !(currentTime + config.getDt() < config.getTimeLimit());
+        const bool writeTick = writesSamples && !pacer.dropsOutput(tick, lastTick) && decimator.tickWanted(tick, currentTime, lastTick);
+        if (writeTick || conflicts) {
+            for (size_t i = 0; i < fleet.size(); i++) {
+                const UAV& uav = fleet.sample(i, tick);
+                if (conflicts)
+                    conflicts->setPosition(i, uav.getX(), uav.getY());
+                if (writeTick && decimator.sampleWanted(i, tick, currentTime, lastTick,
+                    uav.getX(), uav.getY(), uav.getAngleRad(), uav.getState(), uav.isClockwise()))
+                    sink.record(i, currentTime, uav.getX(), uav.getY(), uav.getAngleRad());
+            }
         }
+        if (conflicts) {
+            PROFILE_PHASE(PHASE_CONFLICTS);
+            conflicts->endTick(currentTime);
+        }
+        sink.endTick();
     }
+    if (_VERBOSE)
+        std::cout << "Flight steps: " << fleet.getFlightSteps() << " for " << fleet.size() * (tick - checkpoints.startTick) << " UAV ticks\n";
+}
+
+CheckpointHeader Simulation::checkpointHeader(const size_t tick, const double currentTime) const {
+    CheckpointHeader header;
+    std::memcpy(header.magic, checkpointMagic, sizeof(header.magic));
+    header.version = checkpointVersion;
+    header.engine = static_cast<uint32_t>(config.getEngine());
+    header.uavCount = config.getTotalUavs();
+    header.dt = config.getDt();
+    header.timeLimit = config.getTimeLimit();
+    header.tick = tick;
+    header.currentTime = currentTime;
+    return header;
+}
+
+// the tick thread only copies the state into memory here - and waits for the text output to catch up,
+// so the saved file sizes cover every sample written before this tick. the file is written in the background.
+template <typename SaveEngine>
+void Simulation::saveCheckpoint(Checkpointer& writer, const size_t tick, const double currentTime, TrajectorySink& sink,
+    ConflictDetector* conflicts, const OutputDecimator& decimator, SaveEngine saveEngine) {
+    CheckpointBuffer out;
+    out.put(checkpointHeader(tick, currentTime));
+    std::vector<uint64_t> offsets;
+    sink.checkpoint(offsets);
+    out.putVector(offsets);
+    out.put<uint8_t>(conflicts != nullptr);
+    if (conflicts)
+        conflicts->save(out);
+    commands->save(out);
+    saveEngine(out);
+    decimator.save(out);
+    writer.submit(out.take(), currentTime);
+}
+
+std::unique_ptr<TrajectorySink> Simulation::makeSink(const std::vector<uint64_t>* resumeOffsets) const {
+    if (resumeOffsets && resumeOffsets->size() != ((config.getOutput() == SimConfig::Output::NO_TEXT) ? 0 : config.getTotalUavs())) {
+        throw std::runtime_error("Checkpoint " + config.getResumeFrom() + " does not match the Output setting");
+    }
+    std::unique_ptr<MultiTrajectorySink> sinks = std::make_unique<MultiTrajectorySink>();
+    if (config.getOutput() == SimConfig::Output::TEXT)
+        sinks->add(std::make_unique<TextTrajectorySink>(config.getTotalUavs(), config.getOutputDirectory(), resumeOffsets, !arena));
+    else if (config.getOutput() == SimConfig::Output::ASYNC_TEXT)
+        sinks->add(std::make_unique<AsyncTextTrajectorySink>(config.getTotalUavs(), config.getOutputDirectory(), 0, resumeOffsets, memory()));
+    if (config.getBinaryOutput() != SimConfig::BinaryOutput::BINARY_NONE) {
+        const TrajectoryEncoding encoding =
+            (config.getBinaryOutput() == SimConfig::BinaryOutput::BINARY_F64) ? ENCODE_F64 :
+            (config.getBinaryOutput() == SimConfig::BinaryOutput::BINARY_F32) ? ENCODE_F32 : ENCODE_DELTA32;
+        sinks->add(std::make_unique<BinaryTrajectorySink>(config.outputPath(config.getBinaryFile()), config, encoding));
+    }
+    return sinks;
+}
+
+void Simulation::run() {
+
+#if UAV_PROFILE
+    Profiler::get().reset();
+#else
+    if (!config.getProfileFile().empty())
+        std::cerr << "Warning: ProfileFile is ignored, the program was built without UAV_PROFILE" << '\n';
+#endif
+    if (config.getArena()) {
+        // only the objects engines, outputs and command sources that preallocate everything are arena-backed
+        if (config.getEngine() != SimConfig::Engine::OBJECTS)
+            throw std::runtime_error("Arena = on needs Engine = objects");
+        if (config.getCommandInput() != SimConfig::CommandInput::EAGER || !config.getCommandPipe().empty() || config.getCommandQueue() > 0)
+            throw std::runtime_error("Arena = on needs CommandInput = eager and no CommandPipe or CommandQueue");
+        if (config.getBinaryOutput() != SimConfig::BinaryOutput::BINARY_NONE || config.getSeparation() > 0. ||
+            config.getCheckpointInterval() > 0. || !config.getResumeFrom().empty())
+            throw std::runtime_error("Arena = on does not support BinaryOutput, Separation or checkpoints");
+    }
+    const bool resuming = !config.getResumeFrom().empty();
+    if (config.getCheckpointInterval() > 0. || resuming) {
+        // the analytic engine keeps segments instead of UAV states, and the binary file a chunk index
+        if (config.getEngine() == SimConfig::Engine::ANALYTIC)
+            throw std::runtime_error("Checkpoints are not supported with Engine = analytic");
+        if (config.getBinaryOutput() != SimConfig::BinaryOutput::BINARY_NONE)
+            throw std::runtime_error("Checkpoints are not supported with BinaryOutput");
+    }
+    // a resumed run reads the checkpoint in file order: the outputs, the commands, then (in the tick loop) the UAVs
+    std::unique_ptr<CheckpointReader> resume;
+    std::vector<uint64_t> resumeOffsets;
+    size_t startTick = 0;
+    double startTime = 0.;
+    if (resuming) {
+        resume = std::make_unique<CheckpointReader>(Checkpointer::load(config.getResumeFrom()));
+        const CheckpointHeader header = resume->get<CheckpointHeader>();
+        const CheckpointHeader expected = checkpointHeader(header.tick, header.currentTime);
+        if (std::memcmp(header.magic, checkpointMagic, sizeof(header.magic)) != 0 || header.version != checkpointVersion) {
+            throw std::runtime_error("Not a checkpoint file: " + config.getResumeFrom());
+        }
+        if (header.engine != expected.engine || header.uavCount != expected.uavCount || header.dt != expected.dt || header.timeLimit != expected.timeLimit) {
+            throw std::runtime_error("Checkpoint " + config.getResumeFrom() + " does not match the configuration");
+        }
+        startTick = static_cast<size_t>(header.tick);
+        startTime = header.currentTime;
+        resumeOffsets = resume->getVector<uint64_t>();
+        if ((resume->get<uint8_t>() != 0) != (config.getSeparation() > 0.)) {
+            throw std::runtime_error("Checkpoint " + config.getResumeFrom() + " does not match the Separation setting");
+        }
+    }
+    if (!config.getOutputDirectory().empty())
+        std::filesystem::create_directories(config.getOutputDirectory());
+    std::unique_ptr<TrajectorySink> sink = makeSink(resuming ? &resumeOffsets : nullptr);
+    TickPacer pacer(config.getDt(), config.getRealTimeSpeed(), config.getDropLateOutput());
+    std::unique_ptr<ConflictDetector> conflicts;
+    if (config.getSeparation() > 0.)
+        conflicts = std::make_unique<ConflictDetector>(config.getTotalUavs(), config.getSeparation(), config.outputPath(config.getConflictFile()), resume.get());
+    if (resume)
+        commands->restore(*resume);
+    Checkpointer writer(config);
+    writer.resumedAt(startTime);
+    RunCheckpoints checkpoints{ writer, resume.get(), startTick, startTime };
+    if (_VERBOSE) {
+        if (resume)
+            std::cout << "\n - - - Simulation resumes at " << startTime << " - - - \n";
+        else
+            std::cout << "\n - - - Simulation begins - - - \n";
+    }
+    if (config.getEngine() == SimConfig::Engine::FLEET)
+        runFleet<UavFleet>(*sink, pacer, conflicts.get(), checkpoints);
+    else if (config.getEngine() == SimConfig::Engine::HEADING)
+        runFleet<HeadingFleet>(*sink, pacer, conflicts.get(), checkpoints);
+    else if (config.getEngine() == SimConfig::Engine::ANALYTIC)
+        runAnalytic(*sink, pacer, conflicts.get());
+    else if (config.getEngine() == SimConfig::Engine::MULTIRATE)
+        runMultiRate(*sink, pacer, conflicts.get(), checkpoints);
+    else if (config.getThreads() > 1 && uavs.size() > 1)
+        runObjectsParallel(*sink, pacer, conflicts.get(), checkpoints);
+    else
+        runObjects(*sink, pacer, conflicts.get(), checkpoints);
+    sink->close();
+    pacer.report(std::cout);
+    if (_VERBOSE && arena)
+        std::cout << "Arena: " << arena->getUsed() << " of " << arena->getCapacity() << " bytes used\n";
+    if (conflicts) {
+        conflicts->close();
+        std::cout << "Conflicts below separation " << config.getSeparation() << ": " << conflicts->getConflictCount()
+            << " (see " << config.outputPath(config.getConflictFile()) << ")" << '\n';
+    }
+#if UAV_PROFILE
+    if (config.getProfileFile().empty()) {
+        Profiler::get().report(std::cout);
+    }
+    else {
+        std::ofstream profile(config.outputPath(config.getProfileFile()));
+        if (!profile.is_open()) {
+            throw std::runtime_error("Unable to open file: " + config.outputPath(config.getProfileFile()));
+        }
+        Profiler::get().reportJson(profile);
+    }
+#endif
 }
 
 // constructor - loads config and commands from files and creates UAVs for simulation
 Simulation::Simulation(const std::string configFile, const std::string commandsFile)
-    : config(loadConfig(configFile)), commands(loadCommandsVectorFromFileSorted(commandsFile))
+    : config(loadConfig(configFile)), manifest(FleetManifest::load(config)), commands(makeCommandSource(commandsFile)),
+    scheduler(*commands, config.getTotalUavs(), memory()), airframes(initializeAirframes()), uavs(initializeUAVs())
+{
+}
+
+// (the commands are prepared by the caller, so with Arena = on they stay outside the arena)
+Simulation::Simulation(const SimConfig& config, std::unique_ptr<CommandSource> commands)
+    : config(config), manifest(FleetManifest::load(config)), arena(makeArena(0)), commands(addCommandQueue(std::move(commands))),
+    scheduler(*this->commands, config.getTotalUavs(), memory()), airframes(initializeAirframes()), uavs(initializeUAVs())
 {
-    this->uavs = initializeUAVs(config);
 }
 
 // show data
@@ -206,10 +808,7 @@ void Simulation::showSimulationPrep() {
     std::cout << "Showing config: \n";
     config.showConfig();
     std::cout << "Showing commands: \n";
-    for (const auto &c : commands) {
-        std::cout << "Command time: " << c.getTime() << "x,y: " << c.getX() << "," << c.getY() << " for UAV number: " << c.getUavNum() << "\n";
-
-    }
+    commands->show();
     std::cout << "Showing UAVs:\n";
     for (const auto &u : uavs) {
         u.showUAV();
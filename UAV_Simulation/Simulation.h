@@ -5,36 +5,112 @@
 #include "project_headers.h"
 #include "UAV.h"
 #include "SimConfig.h"
+#include "FleetManifest.h"
 #include "Command.h"
+#include "UavFleet.h"
+#include "AnalyticFleet.h"
+#include "HeadingFleet.h"
+#include "MultiRateFleet.h"
+#include "TickWorkerPool.h"
+#include "TrajectorySink.h"
+#include "CommandSource.h"
+#include "CommandQueue.h"
+#include "CommandScheduler.h"
+#include "TickPacer.h"
+#include "ConflictDetector.h"
+#include "Checkpoint.h"
+#include "OutputDecimator.h"
+#include "SimArena.h"
+#include "StateBuckets.h"
+#include <memory>
+#include <string_view>
 
 class Simulation {
 private:
-    std::vector<UAV> uavs;
     const SimConfig config;
-    std::vector<Command> commands;
+    const FleetManifest manifest; // airframe types and initial states
+    std::unique_ptr<SimArena> arena; // Arena = on: the UAVs, commands, scheduler and output rings live here
+    std::unique_ptr<CommandQueue> commandQueue; // CommandQueue > 0: commands pushed by other threads during the run
+    std::unique_ptr<CommandSource> commands;
+    CommandScheduler scheduler;
+    std::pmr::vector<UAV::Airframe> airframes; // per type, the UAVs point into it
+    std::pmr::vector<UAV> uavs;
 
 
-    std::vector<Command> readCommandsFromFile(const std::string& filename);
-    std::vector<Command> loadCommandsVectorFromFileSorted(const std::string& filename);
+    std::unique_ptr<CommandSource> makeCommandSource(const std::string& filename);
+    // source, merged with the commands of a new commandQueue when the config asks for one
+    std::unique_ptr<CommandSource> addCommandQueue(std::unique_ptr<CommandSource> source);
+    // the arena for Arena = on (null otherwise), sized for the fleet, commandCount commands and the output
+    std::unique_ptr<SimArena> makeArena(const size_t commandCount) const;
+    std::pmr::memory_resource* memory() const;
     // file cleanup functions
-    const std::string trim(const std::string& s);
-    const double readdouble(const std::string& s);
-    const int readint(const std::string& s);
-
-    // load config
-    SimConfig loadConfig(std::string filename);
+    static std::string_view trim(const std::string_view s);
+    static const double readdouble(const std::string_view s);
+    static const size_t readsize(const std::string_view s);
+    static const SimConfig::Engine readEngine(const std::string_view s);
+    static const SimConfig::Output readOutput(const std::string_view s);
+    static const SimConfig::BinaryOutput readBinaryOutput(const std::string_view s);
+    static const SimConfig::CommandInput readCommandInput(const std::string_view s);
+    static const bool readLateOutput(const std::string_view s);
+    static const bool readArena(const std::string_view s);
 
     // show info
     void verboseShowRunInfo();
 
-    const std::vector<UAV> initializeUAVs(const SimConfig& config);
+    std::pmr::vector<UAV::Airframe> initializeAirframes();
+    std::pmr::vector<UAV> initializeUAVs();
+
+    // where a tick loop starts and where it saves checkpoints
+    // (resume is null for a fresh run, otherwise it is positioned at the engine state)
+    struct RunCheckpoints {
+        Checkpointer& writer;
+        CheckpointReader* resume;
+        size_t startTick;
+        double startTime;
+    };
+
+    // tick loops, one per engine
+    // (conflicts is null when the separation check is off)
+    void runObjects(TrajectorySink& sink, TickPacer& pacer, ConflictDetector* conflicts, RunCheckpoints& checkpoints);
+    void runObjectsParallel(TrajectorySink& sink, TickPacer& pacer, ConflictDetector* conflicts, RunCheckpoints& checkpoints);
+    // (UavFleet or HeadingFleet, both have the same interface)
+    template <typename Fleet>
+    void runFleet(TrajectorySink& sink, TickPacer& pacer, ConflictDetector* conflicts, RunCheckpoints& checkpoints);
+    void runAnalytic(TrajectorySink& sink, TickPacer& pacer, ConflictDetector* conflicts);
+    void runMultiRate(TrajectorySink& sink, TickPacer& pacer, ConflictDetector* conflicts, RunCheckpoints& checkpoints);
+
+    // snapshot of the run at the start of a tick, handed to the checkpoint writer (layout in Checkpoint.h)
+    template <typename SaveEngine>
+    void saveCheckpoint(Checkpointer& writer, const size_t tick, const double currentTime, TrajectorySink& sink,
+        ConflictDetector* conflicts, const OutputDecimator& decimator, SaveEngine saveEngine);
+    CheckpointHeader checkpointHeader(const size_t tick, const double currentTime) const;
+
+    std::unique_ptr<TrajectorySink> makeSink(const std::vector<uint64_t>* resumeOffsets) const;
 
 public:
+    // file loading (static, so the benchmarks can time them on their own)
+    // ("time uavNum x y" lines, blank lines skipped - throws with the line number of an invalid line
+    // or of a command for a UAV outside 0 .. uavCount - 1)
+    static std::vector<Command> readCommandsFromFile(const std::string& filename, const size_t uavCount);
+    // the same from text in memory (filename only names it in errors)
+    static std::vector<Command> parseCommands(const char* first, const char* last, const std::string& filename, const size_t uavCount);
+    static SimConfig loadConfig(std::string filename);
+    // the same from any stream (a key given twice keeps its last value)
+    static SimConfig parseConfig(std::istream& configFile);
+    // commands file sorted for VectorCommandSource / SharedCommandSource (latest first). with a cacheFile
+    // the sorted commands come from that CommandCache while it matches the file, and are cached otherwise
+    static std::vector<Command> loadCommandsVectorFromFileSorted(const std::string& filename, const size_t uavCount,
+        const std::string& cacheFile = "");
 
     void run();
 
+    // where other threads push commands while run() goes on (CommandQueue key), null without one
+    CommandQueue* getCommandQueue() const { return commandQueue.get(); }
+
     // constructor
     Simulation(const std::string configFile, const std::string commandsFile);
+    // a prepared configuration and command source (batch mode, see BatchRunner)
+    Simulation(const SimConfig& config, std::unique_ptr<CommandSource> commands);
 
     // show data
     void showSimulationPrep();
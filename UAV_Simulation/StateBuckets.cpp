@@ -0,0 +1,86 @@
+#include "StateBuckets.h"
+
+StateBuckets::StateBuckets(const UAV* uavs, const size_t first, const size_t count, std::pmr::memory_resource* memory)
+	: first(first), count(count), order(count, 0, memory), slot(count, 0, memory), changed(memory)
+{
+	changed.reserve(count);
+	rebuild(uavs);
+}
+
+void StateBuckets::rebuild(const UAV* uavs) {
+	// counting sort by state, UAV number order within each bucket
+	size_t sizes[stateCount] = {};
+	for (size_t i = 0; i < count; i++)
+		sizes[uavs[first + i].getState()]++;
+	begin[0] = 0;
+	for (size_t s = 0; s < stateCount; s++)
+		begin[s + 1] = begin[s] + sizes[s];
+	size_t next[stateCount];
+	std::copy(begin, begin + stateCount, next);
+	for (size_t i = 0; i < count; i++) {
+		const size_t position = next[uavs[first + i].getState()]++;
+		order[position] = first + i;
+		slot[i] = position;
+	}
+	changed.clear();
+	moves = 0;
+}
+
+UavStates::State StateBuckets::bucketAt(const size_t position) const {
+	size_t s = 0;
+	while (position >= begin[s + 1])
+		s++;
+	return static_cast<UavStates::State>(s);
+}
+
+void StateBuckets::swapPositions(const size_t a, const size_t b) {
+	std::swap(order[a], order[b]);
+	slot[order[a] - first] = a;
+	slot[order[b] - first] = b;
+}
+
+void StateBuckets::moveTo(const size_t uavNum, const UavStates::State state) {
+	size_t position = slot[uavNum - first];
+	size_t s = bucketAt(position);
+	moves++;
+	// up: to the last place of the bucket, which then becomes the first place of the next one
+	for (; s < size_t(state); s++) {
+		const size_t last = begin[s + 1] - 1;
+		swapPositions(position, last);
+		position = last;
+		begin[s + 1]--;
+	}
+	// down: to the first place, which then becomes the last place of the previous one
+	for (; s > size_t(state); s--) {
+		const size_t front = begin[s];
+		swapPositions(position, front);
+		position = front;
+		begin[s]++;
+	}
+}
+
+template <UavStates::State S, typename Log>
+void StateBuckets::stepBucket(UAV* uavs) {
+	const size_t* const end = order.data() + begin[S + 1];
+	for (const size_t* uavNum = order.data() + begin[S]; uavNum != end; uavNum++) {
+		if (uavs[*uavNum].template stepIn<S, Log>() != S)
+			changed.push_back(*uavNum);
+	}
+}
+
+template <typename Log>
+void StateBuckets::flightStep(UAV* uavs) {
+	stepBucket<UavStates::CRUISE, Log>(uavs);
+	stepBucket<UavStates::PREP_TURN, Log>(uavs);
+	stepBucket<UavStates::HAS_DEST, Log>(uavs);
+	stepBucket<UavStates::TURN, Log>(uavs);
+	stepBucket<UavStates::ROTATE, Log>(uavs);
+	for (const size_t uavNum : changed)
+		moveTo(uavNum, uavs[uavNum].getState());
+	changed.clear();
+	if (moves > count / 8)
+		rebuild(uavs);
+}
+
+template void StateBuckets::flightStep<QuietLog>(UAV* uavs);
+template void StateBuckets::flightStep<VerboseLog>(UAV* uavs);
@@ -0,0 +1,56 @@
+#ifndef STATE_BUCKETS_H
+#define STATE_BUCKETS_H
+
+#include "project_headers.h"
+#include "UAV.h"
+#include <memory_resource>
+
+// The UAVs of a contiguous range grouped by flight state, for the objects engine. a flight step runs
+// bucket after bucket, each UAV through the UAV::stepIn of its bucket's state, so the hot loop has no
+// state dispatch and a whole batch runs the same code. UAVs migrate between buckets on transitions:
+//  - a step that changed the state is noted, the UAV moves once the whole range was stepped
+//    (so no UAV is stepped twice in a tick)
+//  - a command moves its UAV right away (moveTo), a restore regroups everything (rebuild)
+// the buckets are consecutive segments of one index array: a move is a swap per segment border
+// crossed, at most four. every array is sized up front, stepping never allocates.
+// moves reorder UAVs within a bucket, which does not matter - UAVs do not interact - but scatters the
+// memory accesses of a step, so once an eighth of the range has moved the buckets are rebuilt in order.
+class StateBuckets {
+private:
+	static const size_t stateCount = UavStates::ROTATE + 1;
+
+	size_t first, count;
+	std::pmr::vector<size_t> order;   // UAV numbers, bucket s is order[begin[s] .. begin[s + 1])
+	std::pmr::vector<size_t> slot;    // position of UAV first + i in order
+	size_t begin[stateCount + 1];
+	std::pmr::vector<size_t> changed; // UAVs whose state changed in this step
+	size_t moves;                      // since the last rebuild
+
+	UavStates::State bucketAt(const size_t position) const;
+	void swapPositions(const size_t a, const size_t b);
+
+	template <UavStates::State S, typename Log>
+	void stepBucket(UAV* uavs);
+
+public:
+	// UAVs first .. first + count - 1 of uavs, grouped by their current state
+	StateBuckets(const UAV* uavs, const size_t first, const size_t count,
+		std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+	// what the buckets of count UAVs take, however they are split into ranges (for the arena)
+	static size_t memoryBytes(const size_t count) { return 3 * count * sizeof(size_t); }
+
+	// every UAV into the bucket of its current state again (after a restore)
+	void rebuild(const UAV* uavs);
+
+	// UAV uavNum is now in state (after a command)
+	void moveTo(const size_t uavNum, const UavStates::State state);
+
+	// one flight step of every UAV in the range
+	template <typename Log = BuildLog>
+	void flightStep(UAV* uavs);
+
+	size_t size(const UavStates::State state) const { return begin[state + 1] - begin[state]; }
+};
+
+#endif
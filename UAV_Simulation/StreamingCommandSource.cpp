@@ -0,0 +1,150 @@
+#include "StreamingCommandSource.h"
+#include "Checkpoint.h"
+#include <charconv>
+#include <cstring>
+
+static bool isBlank(const char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static const char* skipBlanks(const char* p, const char* last) {
+	while (p < last && isBlank(*p))
+		p++;
+	return p;
+}
+
+StreamingCommandSource::StreamingCommandSource(const std::string& filename, const size_t window, const size_t uavCount, const size_t chunkSize)
+	: filename(filename), file(filename, std::ios::binary), window((window == 0) ? 1 : window), uavCount(uavCount),
+	buffer(chunkSize), begin(0), end(0), fileOffset(0), endOfFile(false), lineNumber(0), lastTime(-HUGE_VAL), polledTime(-HUGE_VAL)
+{
+	if (!file.is_open()) {
+		throw std::runtime_error("Unable to open file: " + filename);
+	}
+}
+
+bool StreamingCommandSource::parseLine(const char* first, const char* last, Command& command) {
+	double time, x, y;
+	long long uavNum;
+	const char* p = skipBlanks(first, last);
+	std::from_chars_result r = std::from_chars(p, last, time);
+	if (r.ec != std::errc())
+		return false;
+	p = skipBlanks(r.ptr, last);
+	r = std::from_chars(p, last, uavNum);
+	if (r.ec != std::errc() || uavNum < 0)
+		return false;
+	p = skipBlanks(r.ptr, last);
+	r = std::from_chars(p, last, x);
+	if (r.ec != std::errc())
+		return false;
+	p = skipBlanks(r.ptr, last);
+	r = std::from_chars(p, last, y);
+	if (r.ec != std::errc())
+		return false;
+	command = Command(x, y, time, static_cast<size_t>(uavNum));
+	return true;
+}
+
+bool StreamingCommandSource::nextLine(const char*& first, const char*& last) {
+	while (true) {
+		const char* data = buffer.data();
+		const char* newline = static_cast<const char*>(memchr(data + begin, '\n', end - begin));
+		if (newline) {
+			first = data + begin;
+			last = newline;
+			begin = (newline - data) + 1;
+			lineNumber++;
+			return true;
+		}
+		if (endOfFile) {
+			if (begin == end)
+				return false;
+			// last line without a line break
+			first = data + begin;
+			last = data + end;
+			begin = end;
+			lineNumber++;
+			return true;
+		}
+		// move the partial line to the front and read the next chunk behind it
+		const size_t partial = end - begin;
+		memmove(buffer.data(), buffer.data() + begin, partial);
+		begin = 0;
+		end = partial;
+		if (end == buffer.size())
+			buffer.resize(buffer.size() * 2); // a line longer than the chunk
+		file.read(buffer.data() + end, buffer.size() - end);
+		end += static_cast<size_t>(file.gcount());
+		fileOffset += static_cast<uint64_t>(file.gcount());
+		if (!file)
+			endOfFile = true;
+	}
+}
+
+void StreamingCommandSource::refill() {
+	const char* first;
+	const char* last;
+	while (heap.size() < window && nextLine(first, last)) {
+		if (skipBlanks(first, last) == last)
+			continue; // empty line
+		Command command;
+		if (!parseLine(first, last, command)) {
+			throw std::runtime_error("Invalid line format in file " + filename + " at line " + std::to_string(lineNumber));
+		}
+		if (command.getUavNum() >= uavCount) {
+			throw std::runtime_error("Command for UAV " + std::to_string(command.getUavNum()) + " in file " + filename +
+				" at line " + std::to_string(lineNumber) + ", but N_uav = " + std::to_string(uavCount));
+		}
+		if (command.getTime() < lastTime || command.getTime() <= polledTime) {
+			throw std::runtime_error("Commands in " + filename + " are not sorted by time within a window of " +
+				std::to_string(window) + " lines (line " + std::to_string(lineNumber) + ", t = " + std::to_string(command.getTime()) +
+				" comes after its tick), raise CommandWindow or use CommandInput = eager");
+		}
+		heap.push({ command, lineNumber });
+	}
+}
+
+bool StreamingCommandSource::pollDue(const double currentTime, Command& command) {
+	refill();
+	if (heap.empty() || currentTime < heap.top().command.getTime()) {
+		polledTime = currentTime;
+		return false;
+	}
+	command = heap.top().command;
+	lastTime = command.getTime();
+	heap.pop();
+	return true;
+}
+
+void StreamingCommandSource::show() const {
+	std::cout << "Commands streamed from " << filename << ", window of " << window << " commands\n";
+}
+
+void StreamingCommandSource::save(CheckpointBuffer& out) const {
+	out.put<uint64_t>(fileOffset - (end - begin));
+	out.put<uint64_t>(lineNumber);
+	out.put(lastTime);
+	out.put(polledTime);
+	std::vector<Pending> waiting;
+	waiting.reserve(heap.size());
+	for (auto copy = heap; !copy.empty(); copy.pop())
+		waiting.push_back(copy.top());
+	out.putVector(waiting);
+}
+
+void StreamingCommandSource::restore(CheckpointReader& in) {
+	fileOffset = in.get<uint64_t>();
+	lineNumber = static_cast<size_t>(in.get<uint64_t>());
+	lastTime = in.get<double>();
+	polledTime = in.get<double>();
+	heap = decltype(heap)();
+	for (const Pending& p : in.getVector<Pending>())
+		heap.push(p);
+	file.clear();
+	file.seekg(static_cast<std::streamoff>(fileOffset));
+	if (!file) {
+		throw std::runtime_error("Checkpoint does not match the commands file " + filename);
+	}
+	begin = end = 0;
+	endOfFile = false;
+}
@@ -0,0 +1,68 @@
+#ifndef STREAMING_COMMAND_SOURCE_H
+#define STREAMING_COMMAND_SOURCE_H
+
+#include "CommandSource.h"
+#include <cstdint>
+#include <queue>
+
+// Reads the commands file while the simulation runs, instead of loading and sorting all of it first.
+// the file is read in chunks and parsed with std::from_chars, and up to `window` parsed commands wait
+// in a min-heap keyed on (time, line), so memory stays proportional to the window, not the file.
+// the input has to be sorted by time up to that window: every line may come at most `window` lines
+// after a line with a later time. a line arriving too late throws - use the eager VectorCommandSource
+// for unsorted files. too late is a time before a command that was already handed out, or a time
+// at or before a tick whose commands were all handed out (the eager source would have applied it
+// at that tick).
+// commands with the same time come out in file order.
+class StreamingCommandSource : public CommandSource {
+private:
+	struct Pending {
+		Command command;
+		size_t line;
+	};
+	// priority_queue keeps the "largest" on top, so order by "comes later"
+	struct ComesLater {
+		bool operator()(const Pending& a, const Pending& b) const {
+			if (a.command.getTime() != b.command.getTime())
+				return a.command.getTime() > b.command.getTime();
+			return a.line > b.line;
+		}
+	};
+
+	std::string filename;
+	std::ifstream file;
+	size_t window;
+	size_t uavCount;       // commands must be for UAVs 0 .. uavCount - 1
+
+	std::vector<char> buffer;
+	size_t begin, end;     // unparsed bytes in buffer
+	uint64_t fileOffset;   // bytes read from the file so far
+	bool endOfFile;        // nothing more to read into buffer
+	size_t lineNumber;
+	double lastTime;       // time of the last command handed out
+	double polledTime;     // the last tick that got all its commands (pollDue returned false)
+
+	std::priority_queue<Pending, std::vector<Pending>, ComesLater> heap;
+
+	// next line of the file without its line break, false at the end of the file
+	bool nextLine(const char*& first, const char*& last);
+	// top the heap up to the window from the file
+	void refill();
+
+public:
+	StreamingCommandSource(const std::string& filename, const size_t window, const size_t uavCount, const size_t chunkSize = 1 << 20);
+
+	bool pollDue(const double currentTime, Command& command) override;
+
+	void show() const override;
+
+	// the waiting heap and the offset of the first unparsed byte, the rest of the file is read again
+	void save(CheckpointBuffer& out) const override;
+	void restore(CheckpointReader& in) override;
+
+	// parses "time uavNum x y" (extra fields after y are ignored, like the eager loader does),
+	// false if the line does not hold a valid command
+	static bool parseLine(const char* first, const char* last, Command& command);
+};
+
+#endif
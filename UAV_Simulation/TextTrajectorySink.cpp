@@ -0,0 +1,58 @@
+#include "TextTrajectorySink.h"
+#include "AsyncTextTrajectorySink.h"
+#include "Profiler.h"
+#include "Checkpoint.h"
+
+TextTrajectorySink::TextTrajectorySink(const size_t uavCount, const std::string& directory, const std::vector<uint64_t>* resumeOffsets,
+	const bool streamFormatting)
+	: streams(uavCount), streamFormatting(streamFormatting)
+{
+	// initialize file streams and open them
+	for (size_t i = 0; i < uavCount; i++) {
+		openFile(streams[i], directory, i, resumeOffsets);
+	}
+}
+
+TextTrajectorySink::~TextTrajectorySink() {
+	close();
+}
+
+std::string TextTrajectorySink::fileName(const std::string& directory, const size_t uavNum) {
+	const std::string name = "UAV" + std::to_string(uavNum) + ".txt";
+	return directory.empty() ? name : directory + "/" + name;
+}
+
+void TextTrajectorySink::openFile(std::ofstream& stream, const std::string& directory, const size_t uavNum, const std::vector<uint64_t>* resumeOffsets) {
+	if (resumeOffsets == nullptr)
+		stream.open(fileName(directory, uavNum).c_str());
+	else
+		Checkpointer::reopenOutput(stream, fileName(directory, uavNum), resumeOffsets->at(uavNum));
+}
+
+void TextTrajectorySink::record(const size_t uavNum, const double time, const double x, const double y, const double radianAngle) {
+	if (!streamFormatting) {
+		char line[AsyncTextTrajectorySink::maxLineLength];
+		streams[uavNum].write(line, AsyncTextTrajectorySink::formatLine(line, { time, x, y, radianAngle }));
+		return;
+	}
+	// Write current stats to file (we only need degrees here, so we convert here)
+	streams[uavNum] << std::fixed << std::setprecision(2) <<
+		time << " " << x << " " << y << " " << (radianAngle * 180. / M_PI) << '\n';
+}
+
+void TextTrajectorySink::checkpoint(std::vector<uint64_t>& offsets) {
+	for (auto& s : streams) {
+		s.flush();
+		offsets.push_back(static_cast<uint64_t>(s.tellp()));
+	}
+}
+
+void TextTrajectorySink::close() {
+	// close files
+	for (auto& s : streams) {
+		if (s.is_open()) {
+			PROFILE_COUNT(COUNT_BYTES, static_cast<uint64_t>(s.tellp()));
+			s.close();
+		}
+	}
+}
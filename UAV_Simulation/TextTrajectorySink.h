@@ -0,0 +1,33 @@
+#ifndef TEXT_TRAJECTORY_SINK_H
+#define TEXT_TRAJECTORY_SINK_H
+
+#include "TrajectorySink.h"
+
+// the original output: one "UAV<n>.txt" per UAV, formatted through std::ofstream on the calling thread
+// (or, with streamFormatting off, formatted by AsyncTextTrajectorySink::formatLine and written as raw
+// bytes - same text, no locale machinery or allocation per sample)
+class TextTrajectorySink : public TrajectorySink {
+private:
+	std::vector<std::ofstream> streams;
+	bool streamFormatting;
+
+public:
+	// resumeOffsets: the file sizes saved by a checkpoint, to continue those files instead of starting over
+	TextTrajectorySink(const size_t uavCount, const std::string& directory, const std::vector<uint64_t>* resumeOffsets = nullptr,
+		const bool streamFormatting = true);
+	~TextTrajectorySink() override;
+
+	void record(const size_t uavNum, const double time, const double x, const double y, const double radianAngle) override;
+
+	void checkpoint(std::vector<uint64_t>& offsets) override;
+
+	void close() override;
+
+	// "UAV<n>.txt" inside directory (empty directory = working directory)
+	static std::string fileName(const std::string& directory, const size_t uavNum);
+
+	// opens the file of uavNum, truncated, or continued from resumeOffsets
+	static void openFile(std::ofstream& stream, const std::string& directory, const size_t uavNum, const std::vector<uint64_t>* resumeOffsets);
+};
+
+#endif
@@ -0,0 +1,45 @@
+#include "TickPacer.h"
+#include <thread>
+
+// how long before a deadline the pacer stops sleeping and starts spinning
+static const std::chrono::microseconds spinMargin(1500);
+
+TickPacer::TickPacer(const double dt, const double speed, const bool dropLateOutput)
+	: speed(speed), dropLateOutput(dropLateOutput),
+	tickSeconds((speed > 0.) ? dt / speed : 0.),
+	late(false), ticks(0), overruns(0), maxLateness(0), totalLateness(0)
+{
+}
+
+void TickPacer::waitForTick(const size_t tick) {
+	if (!isPaced())
+		return;
+	if (ticks++ == 0) {
+		start = Clock::now() - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(tick * tickSeconds));
+		return;
+	}
+	// from the start every time, so rounding does not add up over the run
+	const Clock::time_point deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(tick * tickSeconds));
+	Clock::time_point now = Clock::now();
+	late = now > deadline;
+	if (late) {
+		overruns++;
+		maxLateness = std::max(maxLateness, now - deadline);
+		totalLateness += now - deadline;
+		return;
+	}
+	if (deadline - now > spinMargin)
+		std::this_thread::sleep_until(deadline - spinMargin);
+	while (Clock::now() < deadline) {
+		// spin
+	}
+}
+
+void TickPacer::report(std::ostream& out) const {
+	if (!isPaced())
+		return;
+	const double maxMs = std::chrono::duration<double, std::milli>(maxLateness).count();
+	const double meanMs = (overruns > 0) ? std::chrono::duration<double, std::milli>(totalLateness).count() / overruns : 0.;
+	out << "Real time x" << speed << ": " << overruns << " of " << ticks << " ticks started late"
+		<< " (mean " << meanMs << " ms, max " << maxMs << " ms)" << (dropLateOutput && overruns > 0 ? ", their samples were dropped" : "") << '\n';
+}
@@ -0,0 +1,44 @@
+#ifndef TICK_PACER_H
+#define TICK_PACER_H
+
+#include "project_headers.h"
+#include <chrono>
+
+// Locks the tick loop to wall-clock time ("RealTime" key): tick k starts k * Dt / speed after the run
+// started. waitForTick() sleeps until shortly before that moment and spins the rest of the way, since
+// sleep_until alone overshoots by up to a scheduler quantum - far more than a 1 ms tick.
+// a tick that could only start after its deadline (the previous one ran too long) is an overrun. the
+// schedule is never shifted, late ticks run back to back until the loop has caught up, and with
+// dropLateOutput their samples are skipped (the decimator writes the next on-time tick instead).
+// speed 0 turns pacing off, every call is then a single branch.
+class TickPacer {
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	double speed;
+	bool dropLateOutput;
+	double tickSeconds; // wall time per tick, Dt / speed
+	Clock::time_point start;
+	bool late;        // the current tick started after its deadline
+	size_t ticks, overruns;
+	Clock::duration maxLateness, totalLateness;
+
+public:
+	TickPacer(const double dt, const double speed, const bool dropLateOutput);
+
+	bool isPaced() const { return speed > 0.; }
+
+	// blocks until tick may start (the first tick starts the clock - tick 0, or where a resumed run starts)
+	void waitForTick(const size_t tick);
+
+	// true when the samples of the current tick should be skipped (never for the first and last tick)
+	bool dropsOutput(const size_t tick, const bool lastTick) const {
+		return late && dropLateOutput && tick != 0 && !lastTick;
+	}
+
+	size_t getOverruns() const { return overruns; }
+
+	void report(std::ostream& out) const;
+};
+
+#endif
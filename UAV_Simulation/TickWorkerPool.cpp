@@ -0,0 +1,64 @@
+#include "TickWorkerPool.h"
+
+// spin a while before giving the core away, most waits are shorter than a context switch
+template <typename Predicate>
+static void waitUntil(Predicate done) {
+	for (size_t spins = 0; !done(); spins++) {
+		if (spins > 1024)
+			std::this_thread::yield();
+	}
+}
+
+TickWorkerPool::TickWorkerPool(const size_t threadCount)
+	: errors(std::max<size_t>(threadCount, 1)), job(nullptr), generation(0), pending(0), stopping(false)
+{
+	for (size_t i = 1; i < threadCount; i++) {
+		workers.emplace_back(&TickWorkerPool::workerLoop, this, i);
+	}
+}
+
+TickWorkerPool::~TickWorkerPool() {
+	stopping.store(true, std::memory_order_release);
+	for (auto& w : workers) {
+		w.join();
+	}
+}
+
+void TickWorkerPool::runJob(const size_t index) {
+	try {
+		(*job)(index);
+	}
+	catch (...) {
+		errors[index] = std::current_exception();
+	}
+}
+
+void TickWorkerPool::workerLoop(const size_t index) {
+	size_t seen = 0;
+	while (true) {
+		waitUntil([&] {
+			return generation.load(std::memory_order_acquire) != seen || stopping.load(std::memory_order_acquire);
+		});
+		if (generation.load(std::memory_order_acquire) == seen)
+			return; // stopping, and no tick left to run
+		seen++;
+		runJob(index);
+		pending.fetch_sub(1, std::memory_order_acq_rel);
+	}
+}
+
+void TickWorkerPool::runTick(const std::function<void(const size_t)>& job) {
+	this->job = &job;
+	pending.store(workers.size(), std::memory_order_relaxed);
+	generation.fetch_add(1, std::memory_order_release); // publishes job and everything the caller wrote before
+	runJob(0);
+	// barrier - every worker's writes are visible after this
+	waitUntil([&] { return pending.load(std::memory_order_acquire) == 0; });
+	for (auto& e : errors) {
+		if (e) {
+			std::exception_ptr error = e;
+			e = nullptr;
+			std::rethrow_exception(error);
+		}
+	}
+}
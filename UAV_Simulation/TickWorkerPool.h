@@ -0,0 +1,53 @@
+#ifndef TICK_WORKER_POOL_H
+#define TICK_WORKER_POOL_H
+
+#include "project_headers.h"
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <exception>
+
+// A fixed set of worker threads that all run the same job once per tick, with a barrier at the end.
+// the calling thread takes part as worker 0, so a pool of size n starts n-1 threads.
+// workers spin (then yield) between ticks instead of sleeping on a condition variable - at Dt = 0.001
+// ticks come back-to-back, and waking a sleeping thread costs more than the tick itself on small shards.
+class TickWorkerPool {
+private:
+	std::vector<std::thread> workers;
+	std::vector<std::exception_ptr> errors; // one slot per participant, rethrown by runTick
+	const std::function<void(const size_t)>* job;
+	std::atomic<size_t> generation;
+	std::atomic<size_t> pending;
+	std::atomic<bool> stopping;
+
+	void workerLoop(const size_t index);
+	void runJob(const size_t index);
+
+public:
+	explicit TickWorkerPool(const size_t threadCount);
+	~TickWorkerPool();
+
+	TickWorkerPool(const TickWorkerPool&) = delete;
+	TickWorkerPool& operator=(const TickWorkerPool&) = delete;
+
+	// number of participants, including the calling thread
+	size_t size() const { return workers.size() + 1; }
+
+	// run job(workerIndex) on every participant and return once all of them finished
+	void runTick(const std::function<void(const size_t)>& job);
+
+	// [begin, end) slice of count items owned by a worker - contiguous, sizes differ by at most one
+	static size_t shardBegin(const size_t worker, const size_t workerCount, const size_t count) {
+		return (count / workerCount) * worker + std::min(worker, count % workerCount);
+	}
+	static size_t shardEnd(const size_t worker, const size_t workerCount, const size_t count) {
+		return shardBegin(worker + 1, workerCount, count);
+	}
+	// the worker owning item (the first count % workerCount slices are one item longer)
+	static size_t shardOf(const size_t item, const size_t workerCount, const size_t count) {
+		const size_t size = count / workerCount, longer = count % workerCount;
+		return (item < longer * (size + 1)) ? item / (size + 1) : longer + (item - longer * (size + 1)) / size;
+	}
+};
+
+#endif
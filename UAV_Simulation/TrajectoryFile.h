@@ -0,0 +1,109 @@
+#ifndef TRAJECTORY_FILE_H
+#define TRAJECTORY_FILE_H
+
+#include "project_headers.h"
+#include <cstdint>
+
+// On-disk layout of the binary trajectory file written by BinaryTrajectorySink and read by TrajectoryReader.
+// (all values little-endian / native, every block starts on an 8 byte boundary)
+//
+//   TrajectoryFileHeader
+//   chunks...           - one UAV, up to chunkCapacity consecutive samples, stored column by column:
+//                         time[n], x[n], y[n], radianAngle[n] in the file's encoding
+//   TrajectoryUavEntry[uavCount]
+//   TrajectoryChunkEntry[chunkCount] - grouped by UAV, in time order
+//   TrajectoryMarker[markerCount]    - grouped by UAV, in time order
+//
+// chunks of different UAVs interleave in the file (they are written as they fill up), the index
+// at the end gives random access to any UAV / sample without scanning.
+static const char trajectoryMagic[8] = { 'U', 'A', 'V', 'T', 'R', 'J', '0', '1' };
+static const uint32_t trajectoryVersion = 2;
+
+enum TrajectoryEncoding : uint32_t {
+	ENCODE_F64 = 0, // every column as double
+	ENCODE_F32 = 1, // time as double, x / y / angle as float
+	ENCODE_DELTA32 = 2  // every column as a double base value followed by float deltas from the previous value
+	                    // (error per value is at most half a float ulp of one step, ~1e-9 for the sample run)
+};
+
+// how a UAV moves between two consecutive samples, from the change of its azimuth:
+// CRUISE / PREP_TURN / HAS_DEST fly straight, TURN / ROTATE turn
+enum TrajectoryPhase : uint32_t {
+	PHASE_STRAIGHT = 0,
+	PHASE_TURN_LEFT = 1,  // azimuth increasing
+	PHASE_TURN_RIGHT = 2  // azimuth decreasing
+};
+
+struct TrajectoryFileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t encoding;
+	// SimConfig of the run
+	double x0, y0, z0, v0, r0, initialAngleRadians, timeLimit, dt;
+	uint64_t uavCount;
+	uint64_t sampleCount;   // over all UAVs
+	uint64_t chunkCapacity;
+	uint64_t chunkCount;
+	uint64_t indexOffset;   // 0 until the writer closed the file
+	uint64_t markerCount;
+};
+
+struct TrajectoryUavEntry {
+	uint64_t firstChunk;  // position in the TrajectoryChunkEntry array
+	uint64_t chunkCount;
+	uint64_t sampleCount;
+	uint64_t firstMarker; // position in the TrajectoryMarker array
+	uint64_t markerCount;
+};
+
+struct TrajectoryChunkEntry {
+	uint64_t offset;      // of the first column, from the start of the file
+	uint64_t firstSample; // index of the chunk's first sample within its UAV
+	uint64_t count;
+	double firstTime, lastTime;
+};
+
+// a phase change: from sample on (at time) the UAV moves in phase, until the next marker
+// (a UAV's first marker is at its first sample, a UAV with less than two samples has none)
+struct TrajectoryMarker {
+	double time;
+	uint64_t sample;
+	uint32_t phase;
+	uint32_t reserved;
+};
+
+static_assert(sizeof(TrajectoryFileHeader) == 128, "unexpected padding in TrajectoryFileHeader");
+static_assert(sizeof(TrajectoryUavEntry) == 40, "unexpected padding in TrajectoryUavEntry");
+static_assert(sizeof(TrajectoryChunkEntry) == 40, "unexpected padding in TrajectoryChunkEntry");
+static_assert(sizeof(TrajectoryMarker) == 24, "unexpected padding in TrajectoryMarker");
+
+inline uint64_t trajectoryAlignUp(const uint64_t n) {
+	return (n + 7) & ~uint64_t(7);
+}
+
+// how a UAV moved from a sample with previousAngle to the next one with radianAngle
+// (changes up to 1e-9 radians count as straight flight)
+inline TrajectoryPhase trajectoryPhaseOf(const double previousAngle, const double radianAngle) {
+	const double change = std::remainder(radianAngle - previousAngle, 2 * M_PI);
+	if (std::abs(change) <= 1e-9)
+		return PHASE_STRAIGHT;
+	return (change > 0.) ? PHASE_TURN_LEFT : PHASE_TURN_RIGHT;
+}
+
+// bytes taken by one column of count samples (padded)
+inline uint64_t trajectoryColumnBytes(const TrajectoryEncoding encoding, const bool timeColumn, const uint64_t count) {
+	if (count == 0)
+		return 0;
+	switch (encoding) {
+	case ENCODE_F64:
+		return count * sizeof(double);
+	case ENCODE_F32:
+		return timeColumn ? count * sizeof(double) : trajectoryAlignUp(count * sizeof(float));
+	case ENCODE_DELTA32:
+		return sizeof(double) + trajectoryAlignUp((count - 1) * sizeof(float));
+	default:
+		throw std::runtime_error("Unknown trajectory encoding");
+	}
+}
+
+#endif
@@ -0,0 +1,84 @@
+#include "TrajectoryQuery.h"
+#include "AsyncTextTrajectorySink.h"
+#include <charconv>
+
+template <typename Number>
+static Number readArgument(const std::string& arg) {
+	Number value;
+	const std::from_chars_result r = std::from_chars(arg.data(), arg.data() + arg.size(), value);
+	if (arg.empty() || r.ec != std::errc() || r.ptr != arg.data() + arg.size()) {
+		throw std::runtime_error("Invalid query argument: " + arg);
+	}
+	return value;
+}
+
+static void printSample(std::ostream& out, const TrajectoryRecord& sample) {
+	char line[AsyncTextTrajectorySink::maxLineLength];
+	out.write(line, AsyncTextTrajectorySink::formatLine(line, sample));
+}
+
+TrajectoryQuery::TrajectoryQuery(const std::string& fileName)
+	: reader(fileName)
+{
+}
+
+size_t TrajectoryQuery::checkedUav(const size_t uavNum) const {
+	if (uavNum >= reader.getUavCount()) {
+		throw std::runtime_error("UAV " + std::to_string(uavNum) + ", but the file has " + std::to_string(reader.getUavCount()) + " UAVs");
+	}
+	return uavNum;
+}
+
+const char* TrajectoryQuery::phaseName(const TrajectoryPhase phase) {
+	switch (phase) {
+	case PHASE_STRAIGHT:
+		return "straight";
+	case PHASE_TURN_LEFT:
+		return "turn-left";
+	case PHASE_TURN_RIGHT:
+		return "turn-right";
+	default:
+		return "unknown";
+	}
+}
+
+bool TrajectoryQuery::printPoint(std::ostream& out, const size_t uavNum, const double t) const {
+	TrajectoryRecord sample;
+	if (!reader.sampleAt(checkedUav(uavNum), t, sample))
+		return false;
+	char line[AsyncTextTrajectorySink::maxLineLength];
+	const size_t length = AsyncTextTrajectorySink::formatLine(line, sample);
+	out.write(line, length - 1); // without its newline
+	out << ' ' << phaseName(reader.phaseAt(uavNum, t)) << '\n';
+	return true;
+}
+
+size_t TrajectoryQuery::printRange(std::ostream& out, const size_t uavNum, const double fromTime, const double toTime) const {
+	const std::vector<TrajectoryRecord> samples = reader.readRange(checkedUav(uavNum), fromTime, toTime);
+	const std::vector<TrajectoryMarker> markers = reader.markersInRange(uavNum, fromTime, toTime);
+	// markers are at sample times, so they merge into the samples by time
+	size_t m = 0;
+	for (const TrajectoryRecord& sample : samples) {
+		for (; m < markers.size() && markers[m].time <= sample.time; m++)
+			out << "# " << std::fixed << std::setprecision(2) << markers[m].time << ' ' << phaseName(static_cast<TrajectoryPhase>(markers[m].phase)) << '\n';
+		printSample(out, sample);
+	}
+	return samples.size();
+}
+
+int TrajectoryQuery::run(const std::vector<std::string>& args, std::ostream& out) {
+	if (args.size() != 3 && args.size() != 4) {
+		throw std::runtime_error("Usage: --query <file> <uavNum> <t> | --query <file> <uavNum> <from> <to>");
+	}
+	const TrajectoryQuery query(args[0]);
+	const size_t uavNum = readArgument<size_t>(args[1]);
+	if (args.size() == 3) {
+		if (!query.printPoint(out, uavNum, readArgument<double>(args[2]))) {
+			std::cerr << "No sample of UAV " << uavNum << " around t = " << args[2] << '\n';
+			return 1;
+		}
+		return 0;
+	}
+	query.printRange(out, uavNum, readArgument<double>(args[2]), readArgument<double>(args[3]));
+	return 0;
+}
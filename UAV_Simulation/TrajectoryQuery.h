@@ -0,0 +1,33 @@
+#ifndef TRAJECTORY_QUERY_H
+#define TRAJECTORY_QUERY_H
+
+#include "TrajectoryReader.h"
+
+// Point and range queries against the binary trajectory file of a past run ("UAV_Simulation --query"):
+//   --query <file> <uavNum> <t>            - the UAV at time t, interpolated between its samples
+//   --query <file> <uavNum> <from> <to>    - its samples with from <= time <= to, and its phase markers
+// samples are printed as UAV<n>.txt lines, with the phase after a point, and a marker as "# <time> <phase>"
+// before the sample it starts at. every lookup is a binary search in the mapped file, nothing is scanned.
+class TrajectoryQuery {
+private:
+	const TrajectoryReader reader;
+
+	size_t checkedUav(const size_t uavNum) const;
+
+public:
+	explicit TrajectoryQuery(const std::string& fileName);
+
+	const TrajectoryReader& getReader() const { return reader; }
+
+	// false if t is outside the UAV's samples
+	bool printPoint(std::ostream& out, const size_t uavNum, const double t) const;
+	// returns the number of samples printed
+	size_t printRange(std::ostream& out, const size_t uavNum, const double fromTime, const double toTime) const;
+
+	static const char* phaseName(const TrajectoryPhase phase);
+
+	// the command line after "--query", returns the exit code
+	static int run(const std::vector<std::string>& args, std::ostream& out);
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include "TrajectoryReader.h"
+#include <cstring>
+
+TrajectoryReader::TrajectoryReader(const std::string& fileName)
+	: file(fileName), header(nullptr), uavEntries(nullptr), chunkEntries(nullptr), markers(nullptr)
+{
+	if (file.size() < sizeof(TrajectoryFileHeader)) {
+		throw std::runtime_error("Not a trajectory file: " + fileName);
+	}
+	header = reinterpret_cast<const TrajectoryFileHeader*>(file.begin());
+	if (std::memcmp(header->magic, trajectoryMagic, sizeof(trajectoryMagic)) != 0 || header->version != trajectoryVersion) {
+		throw std::runtime_error("Not a trajectory file (or unsupported version): " + fileName);
+	}
+	if (header->indexOffset == 0) {
+		throw std::runtime_error("Trajectory file was not closed properly: " + fileName);
+	}
+	const uint64_t indexBytes = header->uavCount * sizeof(TrajectoryUavEntry) + header->chunkCount * sizeof(TrajectoryChunkEntry) +
+		header->markerCount * sizeof(TrajectoryMarker);
+	if (header->indexOffset + indexBytes > file.size()) {
+		throw std::runtime_error("Truncated trajectory file: " + fileName);
+	}
+	uavEntries = reinterpret_cast<const TrajectoryUavEntry*>(file.begin() + header->indexOffset);
+	chunkEntries = reinterpret_cast<const TrajectoryChunkEntry*>(uavEntries + header->uavCount);
+	markers = reinterpret_cast<const TrajectoryMarker*>(chunkEntries + header->chunkCount);
+}
+
+const unsigned char* TrajectoryReader::columnData(const TrajectoryChunkEntry& chunk, const Column column) const {
+	const TrajectoryEncoding encoding = getEncoding();
+	const uint64_t timeBytes = trajectoryColumnBytes(encoding, true, chunk.count);
+	const uint64_t valueBytes = trajectoryColumnBytes(encoding, false, chunk.count);
+	const uint64_t offset = (column == TIME) ? 0 : timeBytes + (column - 1) * valueBytes;
+	return file.begin() + chunk.offset + offset;
+}
+
+const double* TrajectoryReader::column64(const size_t uavNum, const size_t chunk, const Column column) const {
+	const TrajectoryEncoding encoding = getEncoding();
+	if (encoding == ENCODE_F64 || (encoding == ENCODE_F32 && column == TIME))
+		return reinterpret_cast<const double*>(columnData(getChunk(uavNum, chunk), column));
+	return nullptr;
+}
+
+// values [from, from + count) of one column of a chunk, written to out[0], out[stride], ...
+void TrajectoryReader::decodeColumn(const TrajectoryChunkEntry& chunk, const Column column, const size_t from, const size_t count,
+	double* out, const size_t stride) const {
+	const TrajectoryEncoding encoding = getEncoding();
+	const unsigned char* data = columnData(chunk, column);
+	if (encoding == ENCODE_F64 || (encoding == ENCODE_F32 && column == TIME)) {
+		const double* values = reinterpret_cast<const double*>(data);
+		for (size_t k = 0; k < count; k++)
+			out[k * stride] = values[from + k];
+	}
+	else if (encoding == ENCODE_F32) {
+		const float* values = reinterpret_cast<const float*>(data);
+		for (size_t k = 0; k < count; k++)
+			out[k * stride] = static_cast<double>(values[from + k]);
+	}
+	else {
+		// same accumulation order as the encoder, from the chunk's base value
+		double value;
+		std::memcpy(&value, data, sizeof(double));
+		const float* deltas = reinterpret_cast<const float*>(data + sizeof(double));
+		for (size_t k = 0; k < from; k++)
+			value += static_cast<double>(deltas[k]);
+		for (size_t k = 0; k < count; k++) {
+			if (k > 0)
+				value += static_cast<double>(deltas[from + k - 1]);
+			out[k * stride] = value;
+		}
+	}
+}
+
+size_t TrajectoryReader::read(const size_t uavNum, const uint64_t first, const size_t count, TrajectoryRecord* out) const {
+	const uint64_t total = getSampleCount(uavNum);
+	if (first >= total)
+		return 0;
+	const size_t wanted = static_cast<size_t>(std::min<uint64_t>(count, total - first));
+	// chunks are in sample order, find the one holding the first sample
+	const TrajectoryChunkEntry* begin = &getChunk(uavNum, 0);
+	const TrajectoryChunkEntry* end = begin + getChunkCount(uavNum);
+	const TrajectoryChunkEntry* chunk = std::upper_bound(begin, end, first,
+		[](const uint64_t sample, const TrajectoryChunkEntry& c) { return sample < c.firstSample; }) - 1;
+	const size_t stride = sizeof(TrajectoryRecord) / sizeof(double);
+	size_t done = 0;
+	for (; done < wanted; chunk++) {
+		const size_t from = static_cast<size_t>(first + done - chunk->firstSample);
+		const size_t n = std::min<size_t>(wanted - done, static_cast<size_t>(chunk->count) - from);
+		decodeColumn(*chunk, TIME, from, n, &out[done].time, stride);
+		decodeColumn(*chunk, X, from, n, &out[done].x, stride);
+		decodeColumn(*chunk, Y, from, n, &out[done].y, stride);
+		decodeColumn(*chunk, ANGLE, from, n, &out[done].radianAngle, stride);
+		done += n;
+	}
+	return done;
+}
+
+uint64_t TrajectoryReader::lowerBound(const size_t uavNum, const double t) const {
+	const TrajectoryChunkEntry* begin = &getChunk(uavNum, 0);
+	const TrajectoryChunkEntry* end = begin + getChunkCount(uavNum);
+	// first chunk that ends at or after t
+	const TrajectoryChunkEntry* chunk = std::lower_bound(begin, end, t,
+		[](const TrajectoryChunkEntry& c, const double time) { return c.lastTime < time; });
+	if (chunk == end)
+		return getSampleCount(uavNum);
+	if (getEncoding() != ENCODE_DELTA32) {
+		// plain doubles, searched in place
+		const double* times = reinterpret_cast<const double*>(columnData(*chunk, TIME));
+		return chunk->firstSample + (std::lower_bound(times, times + chunk->count, t) - times);
+	}
+	std::vector<double> times(static_cast<size_t>(chunk->count));
+	decodeColumn(*chunk, TIME, 0, times.size(), times.data(), 1);
+	return chunk->firstSample + (std::lower_bound(times.begin(), times.end(), t) - times.begin());
+}
+
+std::vector<TrajectoryRecord> TrajectoryReader::readRange(const size_t uavNum, const double fromTime, const double toTime) const {
+	std::vector<TrajectoryRecord> samples;
+	if (toTime < fromTime)
+		return samples;
+	const uint64_t first = lowerBound(uavNum, fromTime);
+	const uint64_t last = lowerBound(uavNum, std::nextafter(toTime, HUGE_VAL));
+	samples.resize(static_cast<size_t>(last - first));
+	read(uavNum, first, samples.size(), samples.data());
+	return samples;
+}
+
+bool TrajectoryReader::sampleAt(const size_t uavNum, const double t, TrajectoryRecord& out) const {
+	const uint64_t next = lowerBound(uavNum, t);
+	if (next == getSampleCount(uavNum))
+		return false;
+	TrajectoryRecord around[2];
+	if (next == 0) {
+		read(uavNum, 0, 1, &out);
+		return out.time == t;
+	}
+	read(uavNum, next - 1, 2, around);
+	const TrajectoryRecord& a = around[0];
+	const TrajectoryRecord& b = around[1];
+	if (b.time == t) {
+		out = b;
+		return true;
+	}
+	const double f = (t - a.time) / (b.time - a.time);
+	const double turn = std::remainder(b.radianAngle - a.radianAngle, 2 * M_PI);
+	double scale = f, rotation = 0.;
+	if (trajectoryPhaseOf(a.radianAngle, b.radianAngle) != PHASE_STRAIGHT) {
+		// on a circle the chord to the point at f is the whole chord, turned back by (1 - f) * turn / 2
+		scale = std::sin(f * turn / 2) / std::sin(turn / 2);
+		rotation = (f - 1.) * turn / 2;
+	}
+	const double dx = b.x - a.x, dy = b.y - a.y;
+	out.time = t;
+	out.x = a.x + scale * (dx * std::cos(rotation) - dy * std::sin(rotation));
+	out.y = a.y + scale * (dx * std::sin(rotation) + dy * std::cos(rotation));
+	out.radianAngle = a.radianAngle + f * turn;
+	out.radianAngle -= 2 * M_PI * std::floor(out.radianAngle / (2 * M_PI));
+	return true;
+}
+
+TrajectoryPhase TrajectoryReader::phaseAt(const size_t uavNum, const double t) const {
+	const TrajectoryMarker* begin = &getMarker(uavNum, 0);
+	const TrajectoryMarker* end = begin + getMarkerCount(uavNum);
+	// last marker at or before t
+	const TrajectoryMarker* marker = std::upper_bound(begin, end, t,
+		[](const double time, const TrajectoryMarker& m) { return time < m.time; });
+	return (marker == begin) ? PHASE_STRAIGHT : static_cast<TrajectoryPhase>((marker - 1)->phase);
+}
+
+std::vector<TrajectoryMarker> TrajectoryReader::markersInRange(const size_t uavNum, const double fromTime, const double toTime) const {
+	const TrajectoryMarker* begin = &getMarker(uavNum, 0);
+	const TrajectoryMarker* end = begin + getMarkerCount(uavNum);
+	const TrajectoryMarker* first = std::lower_bound(begin, end, fromTime,
+		[](const TrajectoryMarker& m, const double time) { return m.time < time; });
+	const TrajectoryMarker* last = std::upper_bound(first, end, toTime,
+		[](const double time, const TrajectoryMarker& m) { return time < m.time; });
+	return std::vector<TrajectoryMarker>(first, last);
+}
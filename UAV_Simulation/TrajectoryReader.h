@@ -0,0 +1,75 @@
+#ifndef TRAJECTORY_READER_H
+#define TRAJECTORY_READER_H
+
+#include "TrajectoryFile.h"
+#include "TrajectorySink.h"
+#include "MappedFile.h"
+
+// Random access to a binary trajectory file (see TrajectoryFile.h) through a memory mapping.
+// nothing is parsed or copied up front - lookups go through the index at the end of the file.
+// ENCODE_F64 columns (and ENCODE_F32 time columns) can be used in place with column64(),
+// everything else is decoded on demand by read() / readRange().
+// time lookups are binary searches, first over the chunk index, then over the chunk's time column.
+class TrajectoryReader {
+public:
+	enum Column {
+		TIME, X, Y, ANGLE
+	};
+private:
+	MappedFile file;
+	const TrajectoryFileHeader* header;
+	const TrajectoryUavEntry* uavEntries;
+	const TrajectoryChunkEntry* chunkEntries;
+	const TrajectoryMarker* markers;
+
+	const unsigned char* columnData(const TrajectoryChunkEntry& chunk, const Column column) const;
+	void decodeColumn(const TrajectoryChunkEntry& chunk, const Column column, const size_t from, const size_t count,
+		double* out, const size_t stride) const;
+
+public:
+	explicit TrajectoryReader(const std::string& fileName);
+
+	const TrajectoryFileHeader& getHeader() const { return *header; }
+	// the whole file as mapped (the chunks lie between the header and header.indexOffset)
+	const unsigned char* getData() const { return file.begin(); }
+	TrajectoryEncoding getEncoding() const { return static_cast<TrajectoryEncoding>(header->encoding); }
+	size_t getUavCount() const { return static_cast<size_t>(header->uavCount); }
+	uint64_t getSampleCount(const size_t uavNum) const { return uavEntries[uavNum].sampleCount; }
+
+	size_t getChunkCount(const size_t uavNum) const { return static_cast<size_t>(uavEntries[uavNum].chunkCount); }
+	const TrajectoryChunkEntry& getChunk(const size_t uavNum, const size_t chunk) const {
+		return chunkEntries[uavEntries[uavNum].firstChunk + chunk];
+	}
+
+	size_t getMarkerCount(const size_t uavNum) const { return static_cast<size_t>(uavEntries[uavNum].markerCount); }
+	const TrajectoryMarker& getMarker(const size_t uavNum, const size_t marker) const {
+		return markers[uavEntries[uavNum].firstMarker + marker];
+	}
+
+	// the column as stored in the file, when it is stored as plain doubles (nullptr otherwise)
+	const double* column64(const size_t uavNum, const size_t chunk, const Column column) const;
+
+	// copies samples [first, first + count) of a UAV into out, returns how many there were
+	size_t read(const size_t uavNum, const uint64_t first, const size_t count, TrajectoryRecord* out) const;
+
+	// index of the first sample of a UAV with time >= t (getSampleCount if there is none)
+	uint64_t lowerBound(const size_t uavNum, const double t) const;
+
+	// all samples of a UAV with fromTime <= time <= toTime
+	std::vector<TrajectoryRecord> readRange(const size_t uavNum, const double fromTime, const double toTime) const;
+
+	// where the UAV was at time t, between its first and last sample: interpolated along the circular arc
+	// through the two samples around t (a straight line when the azimuth did not change). false outside.
+	// the single arc is only right when the UAV kept one phase between the two samples: one that
+	// finished a turn and flew straight (or started turning) in between is placed on neither path.
+	// the azimuth is in [0, 2*pi), like the samples
+	bool sampleAt(const size_t uavNum, const double t, TrajectoryRecord& out) const;
+
+	// how the UAV moved at time t (straight before its first marker)
+	TrajectoryPhase phaseAt(const size_t uavNum, const double t) const;
+
+	// the markers of a UAV with fromTime <= time <= toTime
+	std::vector<TrajectoryMarker> markersInRange(const size_t uavNum, const double fromTime, const double toTime) const;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef TRAJECTORY_SINK_H
+#define TRAJECTORY_SINK_H
+
+#include "project_headers.h"
+#include <cstdint>
+
+// one output sample of a UAV, as produced by the tick loop
+struct TrajectoryRecord {
+	double time, x, y, radianAngle;
+};
+
+// Destination for the per-tick UAV samples written by Simulation::run().
+// record() may be called from several threads at once, but always for different UAVs,
+// and all samples of one UAV come from the same thread in time order.
+class TrajectorySink {
+public:
+	virtual ~TrajectorySink() = default;
+
+	virtual void record(const size_t uavNum, const double time, const double x, const double y, const double radianAngle) = 0;
+
+	// called once per tick, after every UAV was recorded
+	virtual void endTick() {}
+
+	// for checkpoints: write out everything recorded so far and append the size of each output file to
+	// offsets, a resumed run cuts its files back to them. outputs that cannot be resumed throw
+	virtual void checkpoint(std::vector<uint64_t>& offsets) {
+		(void)offsets;
+		throw std::runtime_error("This output does not support checkpoints");
+	}
+
+	// flush everything and release the outputs, the sink takes no more samples after this
+	virtual void close() = 0;
+};
+
+#endif
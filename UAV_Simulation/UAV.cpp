@@ -1,56 +1,66 @@
 #include "UAV.h"
+#include "Profiler.h"
+#include "Checkpoint.h"
 
 
 // check if we are rotating around the destination clock-wise
-bool UAV::rotatingClockwise() {
-	const double cx = x - destX, cy = y - destY;
-	const double meX = cos(radianAngle), meY = sin(radianAngle);
+template <typename Scalar>
+bool BasicUAV<Scalar>::rotatingClockwise() {
+	const Scalar cx = x - destX, cy = y - destY;
+	const Scalar meX = std::cos(radianAngle), meY = std::sin(radianAngle);
 	return (meX * cy - meY * cx) > 0;
 }
 
-void UAV::confirmArrival() {
+template <typename Scalar>
+template <typename Log>
+void BasicUAV<Scalar>::confirmArrival() {
 	// project next step's distance
-	double nextX, nextY;
-	double nextAngle = radianAngle;
-	double currDist = vec2DDist(x, y, destX, destY);
-	if (currDist >= (1.4 + dt)*turnRadius) // safety distance from centre, we only check in detail when close enough
+	Scalar nextX, nextY;
+	Scalar nextAngle = radianAngle;
+	Scalar currDist = vec2DDist(x, y, destX, destY);
+	if (currDist >= (Scalar(1.4) + airframe->dt)*airframe->turnRadius) // safety distance from centre, we only check in detail when close enough
 		return;
-	if (getState() == UAV::State::TURN) {
+	if (getState() == State::TURN) {
 		// apply turn logic to next values
-		nextAngle = (clockwise) ? (nextAngle - dt * omega) : (nextAngle + dt * omega);
+		nextAngle = (clockwise) ? (nextAngle - airframe->dt * airframe->omega) : (nextAngle + airframe->dt * airframe->omega);
 	}
-	bool rightAngle = equals_epsilon(normalizedDotProduct2D(cos(radianAngle), sin(radianAngle), destX - x, destY - y), 0., dt * velocity / turnRadius);
+	bool rightAngle = equals_epsilon(normalizedDotProduct2D(std::cos(radianAngle), std::sin(radianAngle), destX - x, destY - y), Scalar(0), airframe->dt * airframe->velocity / airframe->turnRadius);
 
-	nextX = x + dt * velocity * cos(nextAngle);
-	nextY = y + dt * velocity * sin(nextAngle);
+	nextX = x + airframe->dt * airframe->velocity * std::cos(nextAngle);
+	nextY = y + airframe->dt * airframe->velocity * std::sin(nextAngle);
 	// if we are at (roughly) 90 degrees angle with vector to center, and we are closest we will be to it, we have arrived
 	if (rightAngle && (currDist < vec2DDist(nextX, nextY, destX, destY))) {
-		setState(UAV::State::ROTATE);
+		if (getState() != State::ROTATE) // PREP_TURN falls through to a second check in the same step
+			PROFILE_TRANSITION(State::ROTATE);
+		setState(State::ROTATE);
 		clockwise = true; // we are going to rotate clock-wise
-		if(_VERBOSE)
+		if constexpr (Log::enabled)
 			std::cout << "Arrived at tangent!\n";
 	}
 }
 
-void UAV::applyAngleChange()
+template <typename Scalar>
+void BasicUAV<Scalar>::applyAngleChange()
 {
 	// apply new angle and correct it from going overboard
-	radianAngle = (clockwise) ? radianAngle - omega * dt : radianAngle + omega * dt;
+	radianAngle = (clockwise) ? radianAngle - airframe->omega * airframe->dt : radianAngle + airframe->omega * airframe->dt;
 	// solution for clamping without explicit ifs - from SO 
-	radianAngle -= (2 * M_PI) * floor(radianAngle / (2 * M_PI));
+	radianAngle -= Scalar(2 * M_PI) * std::floor(radianAngle / Scalar(2 * M_PI));
 }
 
 // in this version we check if we are on the correct angle using law of sines.
 // no course correction here
-void UAV::turnLogic() {
+template <typename Scalar>
+void BasicUAV<Scalar>::turnLogic() {
 	// get angle
-	double sineRatio = sqrt((destX - x) * (destX - x) + (destY - y) * (destY - y)); // sin(90) = 1
+	Scalar sineRatio = std::sqrt((destX - x) * (destX - x) + (destY - y) * (destY - y)); // sin(90) = 1
 	// (using sine theorem)
 	// distToDest / sin(90) = R / sin(theta) -> theta = arcsin(R / distToDest)
-	double theta = asin(turnRadius / sineRatio);
-	double proposedAngle = (getAngleBetweenTwoVectors(1, 0, destX - x, destY - y) * M_PI / 180.) + theta;
-	if (fabs(radianAngle - proposedAngle) <= (dt * velocity / turnRadius)) {
+	Scalar theta = std::asin(airframe->turnRadius / sineRatio);
+	Scalar proposedAngle = (getAngleBetweenTwoVectors<Scalar>(1, 0, destX - x, destY - y) * Scalar(M_PI) / Scalar(180)) + theta;
+	if (std::fabs(radianAngle - proposedAngle) <= (airframe->dt * airframe->velocity / airframe->turnRadius)) {
 		setState(HAS_DEST);
+		PROFILE_TRANSITION(HAS_DEST);
 		return;
 	}
 	applyAngleChange();
@@ -58,93 +68,241 @@ void UAV::turnLogic() {
 
 // Did not manage to prove this is the most efficient way to determine if we can turn,
 // it is for turning directly into a point.
-bool UAV::turnIsPossible() {
+template <typename Scalar>
+bool BasicUAV<Scalar>::turnIsPossible() {
 	// if we are further than 2R from dest, anything is possible (any turn)
-	if (vec2DDist(destX, destY, x, y) >= 2 * turnRadius)
+	if (vec2DDist(destX, destY, x, y) >= 2 * airframe->turnRadius)
 		return true;
 	// else, a more complicated calculation is required - using the circle equation for our potential turn:
-	const double angleToCircleCenter = (clockwise) ? -M_PI_2 : M_PI_2;  // depends on turn direction, pre-calculated
-	const double cX = x + turnRadius * cos(angleToCircleCenter + radianAngle);
-	const double cY = y + turnRadius * sin(angleToCircleCenter + radianAngle);
+	const Scalar angleToCircleCenter = (clockwise) ? -Scalar(M_PI_2) : Scalar(M_PI_2);  // depends on turn direction, pre-calculated
+	const Scalar cX = x + airframe->turnRadius * std::cos(angleToCircleCenter + radianAngle);
+	const Scalar cY = y + airframe->turnRadius * std::sin(angleToCircleCenter + radianAngle);
 	// now, circle equation for the circular motion the UAV can perform is:
 	// (x - cX)^2 + (y - cY)^2 = R
 	// we want to see that, when plugging destX, destY, we get something at least as large as R
 	// this means that we will be able to reach the destination, were we to start turning now
-	const double deltaX = destX - cX;
-	const double deltaY = destY - cY;
-	return (deltaX * deltaX + deltaY * deltaY) >= turnRadius;
+	const Scalar deltaX = destX - cX;
+	const Scalar deltaY = destY - cY;
+	return (deltaX * deltaX + deltaY * deltaY) >= airframe->turnRadius;
 }
 
 // Public methods:
 
-UAV::UAV(const size_t& uavNum, double x, double y, double radianAngle, double velocity, double turnRadius, double dt)
-	: uavNum(uavNum), x(x), y(y), radianAngle(radianAngle), destX(0.), destY(0.),
-	velocity(velocity), turnRadius(turnRadius), omega(velocity / turnRadius), dt(dt), clockwise(false),
-	state(UAV::State::CRUISE)
+template <typename Scalar>
+BasicUAV<Scalar>::BasicUAV(const size_t& uavNum, double x, double y, double radianAngle, const Airframe& airframe)
+	: uavNum(uavNum), x(Scalar(x)), y(Scalar(y)), radianAngle(Scalar(radianAngle)), destX(0), destY(0),
+	airframe(&airframe), clockwise(false), state(State::CRUISE)
 {
 }
 
-void UAV::setDest(const double x,const double y) {
-	this->destX = x;
-	this->destY = y;
+template <typename Scalar>
+void BasicUAV<Scalar>::setDest(const double x,const double y) {
+	this->destX = Scalar(x);
+	this->destY = Scalar(y);
 }
 
-void UAV::acceptCommand(const Command& command) {
+template <typename Scalar>
+template <typename Log>
+void BasicUAV<Scalar>::acceptCommand(const Command& command) {
 	setDest(command.getX(), command.getY());
 	setState(PREP_TURN);
+	PROFILE_TRANSITION(PREP_TURN);
 	// four arguments: unit vector with current azimuth, vector between curr point and dest
 	// order here is important as angle is defined relative to "me" (the UAV).
 	
 	// TODO: use rule-of-sines to adjust this from dest-directed turn to dest-tangent turn
-	const double angleBetweenVectors =
-		getAngleBetweenTwoVectors(cos(radianAngle), sin(radianAngle), destX - x, destY - y);
+	const Scalar angleBetweenVectors =
+		getAngleBetweenTwoVectors(std::cos(radianAngle), std::sin(radianAngle), destX - x, destY - y);
 	
 	// if "my" (UAV -> dest turn) angle is greater than 180, turn clockwise.
 	clockwise = (angleBetweenVectors - radianAngle > 180);
-	if(_VERBOSE)
+	if constexpr (Log::enabled)
 		std::cout << "UAV#" << uavNum << " received command to move to : " << destX << ", " << destY << "\n";
 }
 
-void UAV::handleTurnPreperation()
+template <typename Scalar>
+template <typename Log>
+void BasicUAV<Scalar>::handleTurnPreperation()
 {
 	// this check is used for edge case of being tangent both last and current destination
-	confirmArrival();
-	if (getState() != UAV::State::ROTATE && turnIsPossible())
-		setState(UAV::State::TURN);
+	confirmArrival<Log>();
+	if (getState() != State::ROTATE && turnIsPossible()) {
+		setState(State::TURN);
+		PROFILE_TRANSITION(State::TURN);
+	}
+}
+
+// "state machine" - UAV, one state at a time:
+template <typename Scalar>
+template <UavStates::State S, typename Log>
+UavStates::State BasicUAV<Scalar>::stepIn() {
+	if constexpr (S == State::PREP_TURN) { // check if we can turn (not too close to objective from wrong direction)
+		handleTurnPreperation<Log>();
+		// allow jumping to the correct path if we can start turning now (the HAS_DEST check, in the same step)
+		if (getState() != State::PREP_TURN)
+			confirmArrival<Log>();
+	}
+	else if constexpr (S == State::HAS_DEST) // cruising to destination (no turn yes dest)
+		confirmArrival<Log>();
+	else if constexpr (S == State::TURN) // turning to a destination
+		turnLogic();
+	else if constexpr (S == State::ROTATE) // rotating around the destination
+		applyAngleChange();
+	// (CRUISE, cruising without destination: only the position changes)
+
+	x = x + airframe->dt * airframe->velocity * std::cos(radianAngle);
+	y = y + airframe->dt * airframe->velocity * std::sin(radianAngle);
+	return state;
 }
 
-void UAV::flightStep(const double currentTime) { // current time is used for debug (verbose printing)
-	// "state machine" - UAV:
+template <typename Scalar>
+void BasicUAV<Scalar>::flightStep(const double currentTime) { // current time is used for debug (verbose printing)
 	switch (getState()) {
-	case UAV::State::CRUISE:   // cruising without destination (at first)
+	case State::CRUISE:
+		stepIn<State::CRUISE>();
 		break;
-	case UAV::State::PREP_TURN: // check if we can turn (not too close to objective from wrong direction)
-		handleTurnPreperation();
-		// allow jumping to the correct path if we can start turning now
-		if(getState() == UAV::State::PREP_TURN)
-			break;
-	case UAV::State::HAS_DEST:  // cruising to destination (no turn yes dest)
-		confirmArrival();
+	case State::PREP_TURN:
+		stepIn<State::PREP_TURN>();
 		break;
-	case UAV::State::TURN:	// turning to a destination
-		turnLogic();
+	case State::HAS_DEST:
+		stepIn<State::HAS_DEST>();
 		break;
-	case UAV::State::ROTATE: // rotating around the destination
-		applyAngleChange();
+	case State::TURN:
+		stepIn<State::TURN>();
+		break;
+	case State::ROTATE:
+		stepIn<State::ROTATE>();
 		break;
 	default:
-		throw std::exception("UAV state not-implemented");
+		throw std::runtime_error("UAV state not-implemented");
 	}
+}
 
-	x = x + dt * velocity * cos(radianAngle);
-	y = y + dt * velocity * sin(radianAngle);
+template <typename Scalar>
+void BasicUAV<Scalar>::disturb(const double dx, const double dy, const double dAngle) {
+	x += Scalar(dx);
+	y += Scalar(dy);
+	radianAngle += Scalar(dAngle);
+	radianAngle -= Scalar(2 * M_PI) * std::floor(radianAngle / Scalar(2 * M_PI));
+}
 
-		
+// bounds on the next transition, each with at least one step of slack against rounding:
+//  - CRUISE / ROTATE never change state on their own
+//  - HAS_DEST needs |normalizedDotProduct2D| < tolerance. flying straight, the distance along the heading c
+//    drops by one step length per step while the distance off it (e) stays, and the check can only hold
+//    for |c| < tolerance * e / sqrt(1 - tolerance^2)
+//  - TURN needs the heading within tolerance of the proposed angle. the heading turns by omega * dt per step,
+//    the proposed angle (direction to dest + asin(R / dist)) moves by at most ~L / dist + L * R / (dist * sqrt(dist^2 - R^2))
+//    for a step of length L, so the gap cannot close in fewer steps than gap / (sum of both rates)
+//  - PREP_TURN always takes a single step
+template <typename Scalar>
+size_t BasicUAV<Scalar>::quietSteps(const size_t limit) const {
+	const double length = double(airframe->dt) * double(airframe->velocity);
+	const double tolerance = double(airframe->dt) * double(airframe->velocity) / double(airframe->turnRadius);
+	const double dx = double(destX) - double(x), dy = double(destY) - double(y);
+	double steps = 0.;
+	switch (state) {
+	case State::CRUISE:
+	case State::ROTATE:
+		return limit;
+	case State::HAS_DEST: {
+		const double along = dx * std::cos(double(radianAngle)) + dy * std::sin(double(radianAngle));
+		const double across = std::sqrt(std::max(dx * dx + dy * dy - along * along, 0.));
+		const double window = tolerance * across / std::sqrt(1. - tolerance * tolerance) + length;
+		if (along <= -window) // moving away, the check never holds again
+			return limit;
+		steps = (along - window) / length - 1.;
+		break;
+	}
+	case State::TURN: {
+		const double r = double(airframe->turnRadius);
+		const double dist = std::sqrt(dx * dx + dy * dy);
+		if (dist < r) { // asin(R / dist) is NaN until we get out to R
+			steps = (r - dist) / length - 1.;
+			break;
+		}
+		const double proposed = std::atan2(dy, dx) + std::asin(r / dist);
+		const double gap = std::fabs(std::remainder(double(radianAngle) - proposed, 2 * M_PI));
+		// stay well outside R, so the rate below holds for the whole stretch
+		const double closest = (dist + r) / 2.;
+		const double rate = double(airframe->omega) * double(airframe->dt)
+			+ 2. * (length / closest + length * r / (closest * std::sqrt(closest * closest - r * r)));
+		steps = std::min((gap - 2. * tolerance) / rate, (dist - r) / (2. * length)) - 1.;
+		break;
+	}
+	default:
+		return 0;
+	}
+	return (steps >= double(limit)) ? limit : (steps >= 1.) ? size_t(steps) : 0;
+}
+
+// steps flight steps at once, for steps within quietSteps(): a straight line, or for TURN / ROTATE
+// the sum of steps chords, each turned by omega * dt from the previous one:
+//   sum(j = 1..n) L * e^(i(a + j * s)) = L * sin(n * s / 2) / sin(s / 2) * e^(i(a + (n + 1) * s / 2))
+template <typename Scalar>
+void BasicUAV<Scalar>::flightSteps(const size_t steps) {
+	const Scalar n = Scalar(steps);
+	if (state == State::TURN || state == State::ROTATE) {
+		const Scalar s = (clockwise) ? -(airframe->omega * airframe->dt) : airframe->omega * airframe->dt;
+		const Scalar chord = airframe->dt * airframe->velocity * std::sin(n * s / 2) / std::sin(s / 2);
+		const Scalar mid = radianAngle + (n + 1) * s / 2;
+		x = x + chord * std::cos(mid);
+		y = y + chord * std::sin(mid);
+		radianAngle = radianAngle + n * s;
+		radianAngle -= Scalar(2 * M_PI) * std::floor(radianAngle / Scalar(2 * M_PI));
+		return;
+	}
+	x = x + n * (airframe->dt * airframe->velocity * std::cos(radianAngle));
+	y = y + n * (airframe->dt * airframe->velocity * std::sin(radianAngle));
 }
 
-void UAV::showUAV() const {
+template <typename Scalar>
+void BasicUAV<Scalar>::showUAV() const {
 	// this only prints the important stuff
 	std::cout << "UAV number " << uavNum << ": ";
 	std::cout << "Coordinates (x,y,z): (" << x << ", " << y << ") Azimuth: " << (radianAngle * 180. / M_PI) << '\n';
 }
 
+template <typename Scalar>
+void BasicUAV<Scalar>::save(CheckpointBuffer& out) const {
+	out.put<double>(x);
+	out.put<double>(y);
+	out.put<double>(radianAngle);
+	out.put<double>(destX);
+	out.put<double>(destY);
+	out.put<uint8_t>(static_cast<uint8_t>(state));
+	out.put<uint8_t>(clockwise);
+}
+
+template <typename Scalar>
+void BasicUAV<Scalar>::restore(CheckpointReader& in) {
+	x = Scalar(in.get<double>());
+	y = Scalar(in.get<double>());
+	radianAngle = Scalar(in.get<double>());
+	destX = Scalar(in.get<double>());
+	destY = Scalar(in.get<double>());
+	const uint8_t s = in.get<uint8_t>();
+	if (s > State::ROTATE) {
+		throw std::runtime_error("Invalid UAV state in checkpoint");
+	}
+	state = static_cast<State>(s);
+	clockwise = in.get<uint8_t>() != 0;
+}
+
+template class BasicUAV<float>;
+template class BasicUAV<double>;
+
+// the member templates, for both logging policies
+#define INSTANTIATE_UAV_STEPS(Scalar, Log) \
+	template void BasicUAV<Scalar>::acceptCommand<Log>(const Command&); \
+	template void BasicUAV<Scalar>::handleTurnPreperation<Log>(); \
+	template UavStates::State BasicUAV<Scalar>::stepIn<UavStates::CRUISE, Log>(); \
+	template UavStates::State BasicUAV<Scalar>::stepIn<UavStates::PREP_TURN, Log>(); \
+	template UavStates::State BasicUAV<Scalar>::stepIn<UavStates::HAS_DEST, Log>(); \
+	template UavStates::State BasicUAV<Scalar>::stepIn<UavStates::TURN, Log>(); \
+	template UavStates::State BasicUAV<Scalar>::stepIn<UavStates::ROTATE, Log>();
+
+INSTANTIATE_UAV_STEPS(float, QuietLog)
+INSTANTIATE_UAV_STEPS(float, VerboseLog)
+INSTANTIATE_UAV_STEPS(double, QuietLog)
+INSTANTIATE_UAV_STEPS(double, VerboseLog)
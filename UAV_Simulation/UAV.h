@@ -4,21 +4,60 @@
 #include "project_headers.h"
 #include "Command.h"
 #include "uav_utilities.h"
+#include <type_traits>
 
-// An object representation of a UAV for the simulation, with navigation component
-// according to the stated requirements
-class UAV {
-private:
+class CheckpointBuffer;
+class CheckpointReader;
+
+// scalar type of the UAV state and its guidance math: float when built with UAV_FLOAT32=1 (CMake option
+// UAV_FLOAT32), double otherwise. commands, the config and the output interfaces stay double -
+// values are converted once when they enter or leave a UAV. (UavFleet and AnalyticFleet are double only.)
+#ifndef UAV_FLOAT32
+#define UAV_FLOAT32 0
+#endif
+
+// flight states, the same type for every UAV precision (and for UavFleet / AnalyticFleet)
+struct UavStates {
 	enum State {
 		CRUISE, HAS_DEST, PREP_TURN, TURN, ROTATE
 	};
+};
+
+// logging policies of the UAV flight logic, a template argument of the step functions: the messages
+// are compiled in only for VerboseLog. BuildLog follows the _VERBOSE macro of the build.
+struct QuietLog {
+	static constexpr bool enabled = false;
+};
+struct VerboseLog {
+	static constexpr bool enabled = true;
+};
+typedef std::conditional<bool(_VERBOSE), VerboseLog, QuietLog>::type BuildLog;
+
+// constants of an airframe type (see FleetManifest), shared by every UAV of that type
+template <typename Scalar>
+struct BasicAirframe {
+	Scalar velocity, turnRadius;
+	Scalar omega; // omega is our angular speed, defined according to physics rules
+	Scalar dt;
+
+	BasicAirframe(double velocity, double turnRadius, double dt)
+		: velocity(Scalar(velocity)), turnRadius(Scalar(turnRadius)), omega(Scalar(velocity / turnRadius)), dt(Scalar(dt)) {}
+};
+
+// An object representation of a UAV for the simulation, with navigation component
+// according to the stated requirements
+// (instantiated for float and double in UAV.cpp, UAV below is the one the simulation uses)
+template <typename Scalar>
+class BasicUAV : public UavStates {
+public:
+	typedef BasicAirframe<Scalar> Airframe;
+
+private:
 	size_t uavNum;
-	double x, y; // z is irrelevant for our purpose, though it is stored in the config object
-	double radianAngle;
-	double destX, destY;
-	double velocity, turnRadius;
-	double omega; // omega is our angular speed, defined according to physics rules
-	double dt;
+	Scalar x, y; // z is irrelevant for our purpose, though it is stored in the config object
+	Scalar radianAngle;
+	Scalar destX, destY;
+	const Airframe* airframe; // velocity, turn radius, omega and dt, owned by whoever made the UAV
 	bool clockwise;
 
 	State state;
@@ -26,6 +65,7 @@ private:
 	bool rotatingClockwise();
 
 	// methods for handling flight logic
+	template <typename Log>
 	void confirmArrival();
 
 	void applyAngleChange();
@@ -35,48 +75,70 @@ private:
 	bool turnIsPossible();
 
 public:
-	UAV(const size_t& uavNum, double x, double y, double radianAngle, double velocity, double turnRadius, double dt);
+	// (airframe has to outlive the UAV)
+	BasicUAV(const size_t& uavNum, double x, double y, double radianAngle, const Airframe& airframe);
 
 	void setDest(const double x, const double y);
 
+	template <typename Log = BuildLog>
 	void acceptCommand(const Command& command);
 
+	template <typename Log = BuildLog>
 	void handleTurnPreperation();
 
+	// one flight step of a UAV in state S: the flightStep case of S, without the dispatch.
+	// returns the state after the step (see StateBuckets, which keeps UAVs grouped by it)
+	template <State S, typename Log = BuildLog>
+	State stepIn();
+
 	void flightStep(const double currentTime);
 
+	// an outside disturbance after a flight step (wind, noise - see EnsembleRunner): moves the UAV by
+	// (dx, dy) and turns its heading by dAngle, the guidance reacts to it from the next step on
+	void disturb(const double dx, const double dy, const double dAngle);
+
+	// multi-rate stepping (see MultiRateFleet): how many of the next flight steps (up to limit) are sure
+	// not to change the flight state, and the closed form of that many flight steps at once
+	size_t quietSteps(const size_t limit) const;
+	void flightSteps(const size_t steps);
+
 	size_t getUavNum() { return uavNum; };
 	const size_t getUavNum() const { return uavNum; };
 
 
-	double getX() { return x; };
-	const double getX() const { return x; };
+	Scalar getX() { return x; };
+	const Scalar getX() const { return x; };
+
 
+	Scalar getY() { return y; };
+	const Scalar getY() const { return y; };
 
-	double getY() { return y; };
-	const double getY() const { return y; };
 
+	Scalar getAngleRad() { return radianAngle; };
+	const Scalar getAngleRad() const { return radianAngle; };
 
-	double getAngleRad() { return radianAngle; };
-	const double getAngleRad() const { return radianAngle; };
 
+	Scalar getDestX() { return destX; };
+	const Scalar getDestX() const { return destX; };
 
-	double getDestX() { return destX; };
-	const double getDestX() const { return destX; };
 
+	Scalar getDestY() { return destY; };
+	const Scalar getDestY() const { return destY; };
 
-	double getDestY() { return destY; };
-	const double getDestY() const { return destY; };
+	Scalar getVelocity() { return airframe->velocity; };
+	const Scalar getVelocity() const { return airframe->velocity; };
 
-	double getVelocity() { return velocity; };
-	const double getVelocity() const { return velocity; };
+	Scalar getTurnRadius() { return airframe->turnRadius; };
+	const Scalar getTurnRadius() const { return airframe->turnRadius; };
 
-	double getTurnRadius() { return turnRadius; };
-	const double getTurnRadius() const { return turnRadius; };
+	const Airframe& getAirframe() const { return *airframe; };
 
 	State getState() { return state; };
 	const State getState() const { return state; };
 
+	bool isClockwise() { return clockwise; };
+	const bool isClockwise() const { return clockwise; };
+
 	// setter (for state only)
 	void setState(const State state) {
 		this->state = state;
@@ -84,6 +146,17 @@ public:
 
 	void showUAV() const;
 
+	// flight state for a checkpoint (x, y, radianAngle, dest, state, clockwise - the rest comes from the config),
+	// stored as double whatever the precision
+	void save(CheckpointBuffer& out) const;
+	void restore(CheckpointReader& in);
+
 };
 
+#if UAV_FLOAT32
+typedef BasicUAV<float> UAV;
+#else
+typedef BasicUAV<double> UAV;
+#endif
+
 #endif
\ No newline at end of file
@@ -0,0 +1,222 @@
+#include "UavFleet.h"
+#include "Profiler.h"
+#include "Checkpoint.h"
+
+
+UavFleet::UavFleet(const FleetManifest& fleet, double dt)
+	: count(fleet.size()), dt(dt), airframe(count), runs(fleet.typeRuns()),
+	x(count), y(count), radianAngle(count), destX(count, 0.), destY(count, 0.),
+	state(count, UAV::State::CRUISE), clockwise(count, 0),
+	rotateStep(count, 0.), rotateMask(count, 0.), guidedLeft(false),
+	sines(count, 0.), cosines(count, 0.)
+{
+	for (size_t t = 0; t < fleet.getTypeCount(); t++) {
+		const FleetManifest::Type& type = fleet.getType(t);
+		airframes.push_back({ type.velocity, type.turnRadius, type.velocity / type.turnRadius, dt * type.velocity });
+	}
+	// runs shorter than this on average are not worth a loop each, the kernel looks the type up per drone then
+	const size_t minRunLength = 16;
+	if (runs.size() > 1 && runs.size() * minRunLength > count)
+		runs.clear();
+	for (size_t i = 0; i < count; i++) {
+		const FleetManifest::Placement& start = fleet.getPlacement(i);
+		airframe[i] = start.type;
+		x[i] = start.x;
+		y[i] = start.y;
+		radianAngle[i] = start.radianAngle;
+	}
+	rebuildGroups();
+}
+
+// group every drone by its current state (at the start and after a restore)
+void UavFleet::rebuildGroups() {
+	guided.clear();
+	for (size_t i = 0; i < count; i++) {
+		const UAV::State s = state[i];
+		if (s == UAV::State::PREP_TURN || s == UAV::State::HAS_DEST || s == UAV::State::TURN)
+			guided.push_back(i);
+		setRotating(i, s == UAV::State::ROTATE);
+	}
+	guidedLeft = false;
+}
+
+// drone i into or out of the ROTATE kernel, from the next step on
+void UavFleet::setRotating(const size_t i, const bool rotating) {
+	rotateStep[i] = rotating ? ((clockwise[i]) ? -(airframeOf(i).omega * dt) : airframeOf(i).omega * dt) : 0.;
+	rotateMask[i] = rotating ? 1. : 0.;
+}
+
+void UavFleet::confirmArrival(const size_t i) {
+	// project next step's distance
+	double nextX, nextY;
+	double nextAngle = radianAngle[i];
+	const double currDist = vec2DDist(x[i], y[i], destX[i], destY[i]);
+	if (currDist >= (1.4 + dt) * airframeOf(i).turnRadius) // safety distance from centre, we only check in detail when close enough
+		return;
+	if (state[i] == UAV::State::TURN) {
+		// apply turn logic to next values
+		nextAngle = (clockwise[i]) ? (nextAngle - dt * airframeOf(i).omega) : (nextAngle + dt * airframeOf(i).omega);
+	}
+	const bool rightAngle = equals_epsilon(normalizedDotProduct2D(cos(radianAngle[i]), sin(radianAngle[i]),
+		destX[i] - x[i], destY[i] - y[i]), 0., dt * airframeOf(i).velocity / airframeOf(i).turnRadius);
+
+	nextX = x[i] + dt * airframeOf(i).velocity * cos(nextAngle);
+	nextY = y[i] + dt * airframeOf(i).velocity * sin(nextAngle);
+	// if we are at (roughly) 90 degrees angle with vector to center, and we are closest we will be to it, we have arrived
+	if (rightAngle && (currDist < vec2DDist(nextX, nextY, destX[i], destY[i]))) {
+		if (state[i] != UAV::State::ROTATE) // PREP_TURN falls through to a second check in the same step
+			PROFILE_TRANSITION(UAV::State::ROTATE);
+		state[i] = UAV::State::ROTATE;
+		clockwise[i] = 1; // we are going to rotate clock-wise
+		setRotating(i, true);
+		guidedLeft = true;
+		if (_VERBOSE)
+			std::cout << "Arrived at tangent!\n";
+	}
+}
+
+void UavFleet::applyAngleChange(const size_t i) {
+	// same expression as UAV::applyAngleChange, the batch kernel in flightStep must stay identical to it
+	radianAngle[i] = (clockwise[i]) ? radianAngle[i] - airframeOf(i).omega * dt : radianAngle[i] + airframeOf(i).omega * dt;
+	radianAngle[i] -= (2 * M_PI) * floor(radianAngle[i] / (2 * M_PI));
+}
+
+void UavFleet::turnLogic(const size_t i) {
+	const double dx = destX[i] - x[i], dy = destY[i] - y[i];
+	const double sineRatio = sqrt(dx * dx + dy * dy); // sin(90) = 1
+	const double theta = asin(airframeOf(i).turnRadius / sineRatio);
+	const double proposedAngle = (getAngleBetweenTwoVectors(1., 0., dx, dy) * M_PI / 180.) + theta;
+	if (fabs(radianAngle[i] - proposedAngle) <= (dt * airframeOf(i).velocity / airframeOf(i).turnRadius)) {
+		state[i] = UAV::State::HAS_DEST;
+		PROFILE_TRANSITION(UAV::State::HAS_DEST);
+		return;
+	}
+	applyAngleChange(i);
+}
+
+bool UavFleet::turnIsPossible(const size_t i) {
+	if (vec2DDist(destX[i], destY[i], x[i], y[i]) >= 2 * airframeOf(i).turnRadius)
+		return true;
+	const double angleToCircleCenter = (clockwise[i]) ? -M_PI_2 : M_PI_2;
+	const double cX = x[i] + airframeOf(i).turnRadius * cos(angleToCircleCenter + radianAngle[i]);
+	const double cY = y[i] + airframeOf(i).turnRadius * sin(angleToCircleCenter + radianAngle[i]);
+	const double deltaX = destX[i] - cX;
+	const double deltaY = destY[i] - cY;
+	return (deltaX * deltaX + deltaY * deltaY) >= airframeOf(i).turnRadius;
+}
+
+void UavFleet::handleTurnPreperation(const size_t i) {
+	confirmArrival(i);
+	if (state[i] != UAV::State::ROTATE && turnIsPossible(i)) {
+		state[i] = UAV::State::TURN;
+		PROFILE_TRANSITION(UAV::State::TURN);
+	}
+}
+
+// the UAV::flightStep state machine, minus CRUISE and ROTATE which the batch kernels handle
+void UavFleet::guidanceStep(const size_t i) {
+	switch (state[i]) {
+	case UAV::State::PREP_TURN:
+		handleTurnPreperation(i);
+		if (state[i] == UAV::State::PREP_TURN)
+			break;
+	case UAV::State::HAS_DEST:
+		confirmArrival(i);
+		break;
+	case UAV::State::TURN:
+		turnLogic(i);
+		break;
+	default:
+		break;
+	}
+}
+
+void UavFleet::acceptCommand(const Command& command) {
+	const size_t i = command.getUavNum();
+	destX[i] = command.getX();
+	destY[i] = command.getY();
+	// a drone that was not guided yet joins the list, a rotating one leaves the ROTATE kernel
+	if (state[i] == UAV::State::CRUISE || state[i] == UAV::State::ROTATE)
+		guided.push_back(i);
+	if (state[i] == UAV::State::ROTATE)
+		setRotating(i, false);
+	state[i] = UAV::State::PREP_TURN;
+	PROFILE_TRANSITION(UAV::State::PREP_TURN);
+	const double angleBetweenVectors =
+		getAngleBetweenTwoVectors(cos(radianAngle[i]), sin(radianAngle[i]), destX[i] - x[i], destY[i] - y[i]);
+	clockwise[i] = (angleBetweenVectors - radianAngle[i] > 180) ? 1 : 0;
+	if (_VERBOSE)
+		std::cout << "UAV#" << i << " received command to move to : " << destX[i] << ", " << destY[i] << "\n";
+}
+
+void UavFleet::flightStep(const double currentTime) {
+	// ROTATE drones, branch-free: non-rotating drones add 0 and subtract 0
+	// (the kernel runs before the guidance pass, a drone arriving at its tangent this tick starts rotating next tick, as in UAV)
+	double* angle = radianAngle.data();
+	const double* step = rotateStep.data();
+	const double* mask = rotateMask.data();
+	for (size_t i = 0; i < count; i++) {
+		const double a = angle[i] + step[i];
+		angle[i] = a - mask[i] * ((2 * M_PI) * batchFloor(a / (2 * M_PI)));
+	}
+
+	// drones with an active destination, one at a time
+	for (const size_t i : guided)
+		guidanceStep(i);
+	if (guidedLeft) {
+		guided.erase(std::remove_if(guided.begin(), guided.end(), [this](const size_t i) { return state[i] == UAV::State::ROTATE; }), guided.end());
+		guidedLeft = false;
+	}
+
+	// position update for the whole fleet
+	sincosBatch(radianAngle.data(), sines.data(), cosines.data(), count);
+	double* px = x.data();
+	double* py = y.data();
+	const double* c = cosines.data();
+	const double* s = sines.data();
+	for (const FleetManifest::TypeRun& run : runs) {
+		const double len = airframes[run.type].stepLength;
+		for (size_t i = run.begin; i < run.end; i++) {
+			px[i] = px[i] + len * c[i];
+			py[i] = py[i] + len * s[i];
+		}
+	}
+	if (runs.empty()) {
+		const uint16_t* type = airframe.data();
+		const Airframe* table = airframes.data();
+		for (size_t i = 0; i < count; i++) {
+			const double len = table[type[i]].stepLength;
+			px[i] = px[i] + len * c[i];
+			py[i] = py[i] + len * s[i];
+		}
+	}
+}
+
+void UavFleet::save(CheckpointBuffer& out) const {
+	for (size_t i = 0; i < count; i++) {
+		out.put(x[i]);
+		out.put(y[i]);
+		out.put(radianAngle[i]);
+		out.put(destX[i]);
+		out.put(destY[i]);
+		out.put<uint8_t>(static_cast<uint8_t>(state[i]));
+		out.put<uint8_t>(clockwise[i]);
+	}
+}
+
+void UavFleet::restore(CheckpointReader& in) {
+	for (size_t i = 0; i < count; i++) {
+		x[i] = in.get<double>();
+		y[i] = in.get<double>();
+		radianAngle[i] = in.get<double>();
+		destX[i] = in.get<double>();
+		destY[i] = in.get<double>();
+		const uint8_t s = in.get<uint8_t>();
+		if (s > UAV::State::ROTATE) {
+			throw std::runtime_error("Invalid UAV state in checkpoint");
+		}
+		state[i] = static_cast<UAV::State>(s);
+		clockwise[i] = (in.get<uint8_t>() != 0) ? 1 : 0;
+	}
+	rebuildGroups();
+}
@@ -0,0 +1,91 @@
+#ifndef UAV_FLEET_H
+#define UAV_FLEET_H
+
+#include "project_headers.h"
+#include "Command.h"
+#include "UAV.h"
+#include "FleetManifest.h"
+#include "uav_utilities.h"
+
+class CheckpointBuffer;
+class CheckpointReader;
+
+// Structure-of-arrays version of a vector of UAV objects, for large fleets.
+// every field lives in its own contiguous array, so the per-tick work runs as batch kernels:
+//  - drones in PREP_TURN / HAS_DEST / TURN (short-lived states) are grouped in an index list
+//    and go through the same guidance logic as UAV, one by one
+//  - ROTATE drones get their angle change from a branch-free kernel over the whole fleet
+//  - the position update for all drones uses sincosBatch instead of cos/sin per drone
+// angles are computed exactly as in UAV, so azimuths match bit for bit. positions differ only
+// by the sincosBatch rounding (<= 1 ulp per step): ~1e-13 after 60k ticks in the sample scenario,
+// so the 2-decimal text output is identical. (a tangent/turn check sitting exactly on its
+// threshold could in principle flip one tick earlier or later.)
+// velocity / turn radius live once per airframe type, the position update runs over the runs of
+// same-type drones with the type's step length held in a register.
+class UavFleet {
+private:
+	struct Airframe {
+		double velocity, turnRadius;
+		double omega;
+		double stepLength; // dt * velocity, as used by the position update
+	};
+
+	size_t count;
+	double dt;
+
+	std::vector<Airframe> airframes;          // per type
+	std::vector<uint16_t> airframe;           // per drone, index into airframes
+	std::vector<FleetManifest::TypeRun> runs; // of drones sharing a type, empty when the types are interleaved
+
+	std::vector<double> x, y;
+	std::vector<double> radianAngle;
+	std::vector<double> destX, destY;
+	std::vector<UAV::State> state;
+	std::vector<unsigned char> clockwise;
+
+	// per-state grouping, kept up to date drone by drone as commands and transitions change states
+	// (only a restore rebuilds it from scratch)
+	std::vector<size_t> guided;        // indices in PREP_TURN, HAS_DEST or TURN
+	std::vector<double> rotateStep;    // signed omega * dt for ROTATE drones, 0 otherwise
+	std::vector<double> rotateMask;    // 1 for ROTATE drones, 0 otherwise
+	bool guidedLeft;                   // some guided drone started rotating in this step
+
+	// scratch space for the batch kernels
+	std::vector<double> sines, cosines;
+
+	void rebuildGroups();
+	void setRotating(const size_t i, const bool rotating);
+
+	const Airframe& airframeOf(const size_t i) const { return airframes[airframe[i]]; }
+
+	// per-drone guidance, same logic as the UAV methods of the same name
+	void confirmArrival(const size_t i);
+	void applyAngleChange(const size_t i);
+	void turnLogic(const size_t i);
+	bool turnIsPossible(const size_t i);
+	void handleTurnPreperation(const size_t i);
+	void guidanceStep(const size_t i);
+
+public:
+	UavFleet(const FleetManifest& fleet, double dt);
+
+	void acceptCommand(const Command& command);
+
+	void flightStep(const double currentTime);
+
+	size_t size() const { return count; }
+
+	double getX(const size_t i) const { return x[i]; }
+	double getY(const size_t i) const { return y[i]; }
+	double getAngleRad(const size_t i) const { return radianAngle[i]; }
+	double getDestX(const size_t i) const { return destX[i]; }
+	double getDestY(const size_t i) const { return destY[i]; }
+	UAV::State getState(const size_t i) const { return state[i]; }
+	bool isClockwise(const size_t i) const { return clockwise[i] != 0; }
+
+	// every drone's flight state for a checkpoint, in the same layout as UAV::save
+	void save(CheckpointBuffer& out) const;
+	void restore(CheckpointReader& in);
+};
+
+#endif
@@ -0,0 +1,34 @@
+#include "VectorCommandSource.h"
+#include "Checkpoint.h"
+
+VectorCommandSource::VectorCommandSource(std::vector<Command> sortedCommands)
+	: commands(sortedCommands.begin(), sortedCommands.end())
+{
+}
+
+VectorCommandSource::VectorCommandSource(const std::vector<Command>& sortedCommands, std::pmr::memory_resource* resource)
+	: commands(sortedCommands.begin(), sortedCommands.end(), resource)
+{
+}
+
+bool VectorCommandSource::pollDue(const double currentTime, Command& command) {
+	if (commands.empty() || currentTime < commands.back().getTime())
+		return false;
+	command = commands.back();
+	commands.pop_back();  // assuming there are thousands of commands, we remove them during simulation to maintain low memory footprint
+	return true;
+}
+
+void VectorCommandSource::show() const {
+	for (const auto& c : commands)
+		c.showCommand();
+}
+
+void VectorCommandSource::save(CheckpointBuffer& out) const {
+	out.putVector(commands);
+}
+
+void VectorCommandSource::restore(CheckpointReader& in) {
+	const std::vector<Command> saved = in.getVector<Command>();
+	commands.assign(saved.begin(), saved.end());
+}
@@ -0,0 +1,26 @@
+#ifndef VECTOR_COMMAND_SOURCE_H
+#define VECTOR_COMMAND_SOURCE_H
+
+#include "CommandSource.h"
+#include <memory_resource>
+
+// the whole commands file, loaded and sorted before the simulation starts.
+// works for input in any order, used when CommandInput = eager (default)
+class VectorCommandSource : public CommandSource {
+private:
+	std::pmr::vector<Command> commands; // sorted from latest to earliest, due commands are popped off the back
+
+public:
+	VectorCommandSource(std::vector<Command> sortedCommands);
+	// the commands copied into resource (see SimArena)
+	VectorCommandSource(const std::vector<Command>& sortedCommands, std::pmr::memory_resource* resource);
+
+	bool pollDue(const double currentTime, Command& command) override;
+
+	void show() const override;
+
+	void save(CheckpointBuffer& out) const override;
+	void restore(CheckpointReader& in) override;
+};
+
+#endif
@@ -1,12 +1,46 @@
-// memory leak detection
+// memory leak detection (MSVC debug heap only)
+#ifdef _MSC_VER
 #define _CRTDBG_MAP_ALLOC
 #include<crtdbg.h>
+#endif
 #include "Simulation.h"
+#include "BatchRunner.h"
+#include "ShardRunner.h"
+#include "ShardProcess.h"
+#include "TrajectoryQuery.h"
+#include "EnsembleRunner.h"
 
-int main()
+int main(int argc, char* argv[])
 try {
+#ifdef _MSC_VER
     // checking for memory leaks while avoiding false positives from static objects in some libraries
     _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
+#endif
+
+    // batch mode: UAV_Simulation --sweep <spec>
+    if (argc == 3 && std::string(argv[1]) == "--sweep") {
+        BatchRunner batch(argv[2]);
+        return (batch.run() == 0) ? 0 : 1;
+    }
+
+    // Monte Carlo mode: UAV_Simulation --ensemble <spec>
+    if (argc == 3 && std::string(argv[1]) == "--ensemble") {
+        EnsembleRunner ensemble(argv[2]);
+        ensemble.run();
+        return 0;
+    }
+
+    // sharded mode: UAV_Simulation --shards <N> (it starts N processes of UAV_Simulation --shard-worker)
+    if (argc == 3 && std::string(argv[1]) == "--shards") {
+        ShardRunner shards(ShardProcess::currentExecutable(argv[0]), "SimParams.ini", "SimCmds.txt", std::stoul(argv[2]));
+        return (shards.run() == 0) ? 0 : 1;
+    }
+    if (argc == 2 && std::string(argv[1]) == "--shard-worker")
+        return ShardRunner::runWorker(std::cin);
+
+    // query mode: UAV_Simulation --query <file> <uavNum> <t> | <from> <to> (against a run's BinaryFile)
+    if (argc >= 2 && std::string(argv[1]) == "--query")
+        return TrajectoryQuery::run(std::vector<std::string>(argv + 2, argv + argc), std::cout);
 
     Simulation sim("SimParams.ini", 
         "SimCmds.txt");
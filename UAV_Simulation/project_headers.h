@@ -12,7 +12,9 @@
 #include <stdexcept>
 #include <iomanip> // Include for std::setprecision 
 
-// debug printing
+// debug printing (the benchmarks build with _VERBOSE=false)
+#ifndef _VERBOSE
 #define _VERBOSE true
+#endif
 
 #endif
\ No newline at end of file
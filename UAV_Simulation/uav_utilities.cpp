@@ -1,36 +1,91 @@
 #include "uav_utilities.h"
 
 // check if two values are close enough to each other (dist < epsilon)
-bool equals_epsilon(const double a, const double b, const double epsilon) {
-	return fabs(a - b) < epsilon;
+template <typename Scalar>
+bool equals_epsilon(const Scalar a, const Scalar b, const Scalar epsilon) {
+	return std::fabs(a - b) < epsilon;
 }
 
 // standard vector distance
-double vec2DDist(const double x1, const double y1, const double x2, const double y2) {
-	const double diffx = x2 - x1;
-	const double diffy = y2 - y1;
-	return sqrt(diffx * diffx + diffy * diffy);
+template <typename Scalar>
+Scalar vec2DDist(const Scalar x1, const Scalar y1, const Scalar x2, const Scalar y2) {
+	const Scalar diffx = x2 - x1;
+	const Scalar diffy = y2 - y1;
+	return std::sqrt(diffx * diffx + diffy * diffy);
 }
 
 // standard vector dot product
-double dotProduct2D(const double x1, const double y1, const double x2, const double y2) {
+template <typename Scalar>
+Scalar dotProduct2D(const Scalar x1, const Scalar y1, const Scalar x2, const Scalar y2) {
 	return x1 * x2 + y1 * y2;
 }
 
 // provides angle between two vectors in degrees(!)
-double getAngleBetweenTwoVectors(const double x1, const double y1, const double x2, const double y2) {
+template <typename Scalar>
+Scalar getAngleBetweenTwoVectors(const Scalar x1, const Scalar y1, const Scalar x2, const Scalar y2) {
 	// details (from the stack-overflow page)
 	// v1=vector1, v2=vector2
 	//res = -atan2(v1[0] * v2[1] - v2[0] * v1[1], sum(a * b for a, b in zip(v1, v2)))
 	//angle = (-180 / pi * res) % 360
 	// this gives us the angle in degrees, if it's > 180, we turn clockwise.
-	const double res = atan2(x1 * y2 - x2 * y1, x1 * x2 + y1 * y2) * 180. / M_PI;
-	const double tmp = fmod(res, 360.);
-	return res < 0 ? tmp + 360. : tmp;  // double modulo implementation for clamping angle between 0 and 360
+	const Scalar res = std::atan2(x1 * y2 - x2 * y1, x1 * x2 + y1 * y2) * Scalar(180) / Scalar(M_PI);
+	const Scalar tmp = std::fmod(res, Scalar(360));
+	return res < 0 ? tmp + Scalar(360) : tmp;  // double modulo implementation for clamping angle between 0 and 360
 }
 
 // dot product of the directions of the vectors, used to avoid scale issues
-double normalizedDotProduct2D(const double x1, const double y1, const double x2, const double y2) {
-	const double magProd = (sqrt(x1 * x1 + y1 * y1) * sqrt(x2 * x2 + y2 * y2));
+template <typename Scalar>
+Scalar normalizedDotProduct2D(const Scalar x1, const Scalar y1, const Scalar x2, const Scalar y2) {
+	const Scalar magProd = (std::sqrt(x1 * x1 + y1 * y1) * std::sqrt(x2 * x2 + y2 * y2));
 	return ((x1 * x2) / magProd) + ((y1 * y2) / magProd);
-}
\ No newline at end of file
+}
+
+// the two precisions UAV is built with (see UAV_FLOAT32)
+#define UAV_UTILITIES_INSTANTIATE(Scalar) \
+	template bool equals_epsilon<Scalar>(const Scalar, const Scalar, const Scalar); \
+	template Scalar vec2DDist<Scalar>(const Scalar, const Scalar, const Scalar, const Scalar); \
+	template Scalar dotProduct2D<Scalar>(const Scalar, const Scalar, const Scalar, const Scalar); \
+	template Scalar getAngleBetweenTwoVectors<Scalar>(const Scalar, const Scalar, const Scalar, const Scalar); \
+	template Scalar normalizedDotProduct2D<Scalar>(const Scalar, const Scalar, const Scalar, const Scalar);
+UAV_UTILITIES_INSTANTIATE(float)
+UAV_UTILITIES_INSTANTIATE(double)
+#undef UAV_UTILITIES_INSTANTIATE
+
+// polynomial sine/cosine over a whole array, branch-free so the loop vectorizes.
+// the argument is reduced to [-pi/4, pi/4] (Cody-Waite, three-part pi/2) and evaluated with the
+// fdlibm kernel polynomials, max error is ~1 ulp against std::sin/std::cos for |angle| < 1e5.
+void sincosBatch(const double* angles, double* sines, double* cosines, const size_t count) {
+	const double twoOverPi = 6.36619772367581382433e-01;
+	const double pio2_1 = 1.57079632673412561417e+00;
+	const double pio2_2 = 6.07710050630396597660e-11;
+	const double pio2_3 = 2.02226624871116645580e-21;
+	const double S1 = -1.66666666666666324348e-01, S2 = 8.33333333332248946124e-03,
+		S3 = -1.98412698298579493134e-04, S4 = 2.75573137070700676789e-06,
+		S5 = -2.50507602534068634195e-08, S6 = 1.58969099521155010221e-10;
+	const double C1 = 4.16666666666666019037e-02, C2 = -1.38888888888741095749e-03,
+		C3 = 2.48015872894767294178e-05, C4 = -2.75573143513906633035e-07,
+		C5 = 2.08757232129817482790e-09, C6 = -1.13596475577881948265e-11;
+
+	for (size_t i = 0; i < count; i++) {
+		const double a = angles[i];
+		// q = nearest integer to a / (pi/2), its two's complement low bits are the quadrant
+		const double shifted = a * twoOverPi + roundingShifter;
+		const double q = shifted - roundingShifter;
+		uint64_t quadrant;
+		std::memcpy(&quadrant, &shifted, sizeof(quadrant));
+		const double r = ((a - q * pio2_1) - q * pio2_2) - q * pio2_3;
+		const double z = r * r;
+		const double s = r + r * z * (S1 + z * (S2 + z * (S3 + z * (S4 + z * (S5 + z * S6)))));
+		const double c = 1.0 - 0.5 * z + z * z * (C1 + z * (C2 + z * (C3 + z * (C4 + z * (C5 + z * C6)))));
+		// quadrant (q mod 4) decides which kernel result goes where, and with which sign:
+		// bit 0 swaps sine and cosine, the signs are flipped on the bits instead of with branches
+		uint64_t sBits, cBits;
+		std::memcpy(&sBits, &s, sizeof(sBits));
+		std::memcpy(&cBits, &c, sizeof(cBits));
+		const uint64_t swap = 0 - (quadrant & 1);
+		const uint64_t sinBits = ((cBits & swap) | (sBits & ~swap)) ^ ((quadrant & 2) << 62);
+		const uint64_t cosBits = ((sBits & swap) | (cBits & ~swap)) ^ (((quadrant + 1) & 2) << 62);
+		std::memcpy(&sines[i], &sinBits, sizeof(sinBits));
+		std::memcpy(&cosines[i], &cosBits, sizeof(cosBits));
+	}
+}
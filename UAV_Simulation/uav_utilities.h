@@ -2,12 +2,38 @@
 #define UAV_UTILITIES_H
 
 #include "project_headers.h"
+#include <cstdint>
+#include <cstring>
 
 // helper functions used by the UAV class, which are not directly object-related
 // possible suggestion is to define a Vector class which implements these instead
-bool equals_epsilon(const double a, const double b, const double epsilon);
-double vec2DDist(const double x1, const double y1, const double x2, const double y2);
-double dotProduct2D(const double x1, const double y1, const double x2, const double y2);
-double getAngleBetweenTwoVectors(const double x1, const double y1, const double x2, const double y2);
-double normalizedDotProduct2D(const double x1, const double y1, const double x2, const double y2);
+// (templates on the scalar type, instantiated for float and double in uav_utilities.cpp)
+template <typename Scalar> bool equals_epsilon(const Scalar a, const Scalar b, const Scalar epsilon);
+template <typename Scalar> Scalar vec2DDist(const Scalar x1, const Scalar y1, const Scalar x2, const Scalar y2);
+template <typename Scalar> Scalar dotProduct2D(const Scalar x1, const Scalar y1, const Scalar x2, const Scalar y2);
+template <typename Scalar> Scalar getAngleBetweenTwoVectors(const Scalar x1, const Scalar y1, const Scalar x2, const Scalar y2);
+template <typename Scalar> Scalar normalizedDotProduct2D(const Scalar x1, const Scalar y1, const Scalar x2, const Scalar y2);
+
+// batch helpers used by the UavFleet kernels, written so the compiler can vectorize them
+// (no floor() / int conversions, which have no SSE2 form - the default x86-64 build would go scalar)
+void sincosBatch(const double* angles, double* sines, double* cosines, const size_t count);
+
+// adding it rounds a double below 2^51 to the nearest integer, which then sits in the low mantissa bits
+const double roundingShifter = 6755399441055744.0; // 1.5 * 2^52
+
+// floor(x) for |x| < 2^51, exact. one less than the nearest integer when x lies below it - taken from
+// the sign bit, since a floating point compare in a loop keeps GCC from vectorizing it (-ftrapping-math).
+// (+ 0. turns the -0 of x = -0 into +0, and floor(x) always has the sign of x)
+inline double batchFloor(const double x) {
+	const double nearest = (x + roundingShifter) - roundingShifter;
+	const double below = (x - nearest) + 0.;
+	const double one = 1.;
+	uint64_t sign, step;
+	std::memcpy(&sign, &below, sizeof(sign));
+	std::memcpy(&step, &one, sizeof(step));
+	step &= 0 - (sign >> 63);
+	double correction;
+	std::memcpy(&correction, &step, sizeof(correction));
+	return std::copysign(nearest - correction, x);
+}
 #endif
\ No newline at end of file
@@ -0,0 +1,316 @@
+// Google Benchmark suite for the simulation: flight kernels, whole runs, input parsing and output.
+// every input is generated from a fixed seed into <temp>/uav_bench, so numbers are comparable between builds:
+//   uav_benchmarks --benchmark_out=before.json   (then compare.py from the benchmark package)
+#include "Simulation.h"
+#include "StreamingCommandSource.h"
+#include "CommandQueue.h"
+#include "TextTrajectorySink.h"
+#include "AsyncTextTrajectorySink.h"
+#include "BinaryTrajectorySink.h"
+#include "TrajectoryReader.h"
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <thread>
+
+static const unsigned benchSeed = 20240601;
+
+static const std::filesystem::path& benchDir() {
+	static const std::filesystem::path dir = [] {
+		const std::filesystem::path d = std::filesystem::temp_directory_path() / "uav_bench";
+		std::filesystem::create_directories(d);
+		return d;
+	}();
+	return dir;
+}
+
+static std::string benchPath(const std::string& name) {
+	return (benchDir() / name).string();
+}
+
+// SimParams.ini of the sample run, with extra (optional) keys appended
+static std::string writeConfig(const std::string& name, const size_t uavs, const double timeLimit, const std::string& extra) {
+	const std::string path = benchPath(name);
+	std::ofstream file(path);
+	file << "Dt = 0.001\nN_uav = " << uavs << "\nR = 100.0\nX0 = 500.0\nY0 = 0.0\nZ0 = 500.0\nV0 = 60.0\nAz = 0.0\n"
+		<< "TimeLim = " << timeLimit << "\n" << extra;
+	return path;
+}
+
+// count commands for random UAVs at increasing times within timeLimit, destinations within 2 km
+static std::string writeCommands(const std::string& name, const size_t count, const size_t uavs, const double timeLimit) {
+	const std::string path = benchPath(name);
+	std::mt19937_64 random(benchSeed);
+	std::uniform_int_distribution<size_t> uav(0, uavs - 1);
+	std::uniform_real_distribution<double> coordinate(-2000., 2000.);
+	std::ofstream file(path);
+	file << std::fixed << std::setprecision(3);
+	for (size_t i = 0; i < count; i++) {
+		file << timeLimit * i / count << ' ' << uav(random) << ' ' << coordinate(random) << ' ' << coordinate(random) << '\n';
+	}
+	return path;
+}
+
+// ---- UAV::flightStep, one state at a time ----
+
+// 256 UAVs in the given state, with destinations 0.5R to 4R away so the close-range checks run too
+static std::vector<UAV> makePrototypes(const UAV::State state) {
+	const double radius = 100., velocity = 60., dt = 0.001;
+	static const UAV::Airframe airframe(velocity, radius, dt);
+	std::mt19937_64 random(benchSeed);
+	std::uniform_real_distribution<double> unit(0., 1.);
+	std::vector<UAV> prototypes;
+	for (size_t i = 0; i < 256; i++) {
+		UAV uav(i, 2000. * unit(random), 2000. * unit(random), 2 * M_PI * unit(random), airframe);
+		const double distance = radius * (0.5 + 3.5 * unit(random)), bearing = 2 * M_PI * unit(random);
+		const double destX = uav.getX() + distance * cos(bearing), destY = uav.getY() + distance * sin(bearing);
+		if (state != UAV::State::CRUISE) {
+			uav.acceptCommand(Command(destX, destY, 0., i)); // PREP_TURN
+			uav.setState(state);
+		}
+		prototypes.push_back(uav);
+	}
+	return prototypes;
+}
+
+// each iteration steps a fresh copy of a prototype, so the UAV never leaves the measured state
+static void BM_FlightStep(benchmark::State& bench, const UAV::State state) {
+	const std::vector<UAV> prototypes = makePrototypes(state);
+	size_t i = 0;
+	for (auto _ : bench) {
+		UAV uav = prototypes[i++ & 255];
+		uav.flightStep(0.);
+		benchmark::DoNotOptimize(uav.getX());
+		benchmark::DoNotOptimize(uav.getY());
+	}
+	bench.SetItemsProcessed(bench.iterations());
+}
+BENCHMARK_CAPTURE(BM_FlightStep, cruise, UAV::State::CRUISE);
+BENCHMARK_CAPTURE(BM_FlightStep, prep_turn, UAV::State::PREP_TURN);
+BENCHMARK_CAPTURE(BM_FlightStep, has_dest, UAV::State::HAS_DEST);
+BENCHMARK_CAPTURE(BM_FlightStep, turn, UAV::State::TURN);
+BENCHMARK_CAPTURE(BM_FlightStep, rotate, UAV::State::ROTATE);
+
+// ---- Simulation::run(), end to end ----
+
+// loading, then 250 ticks with one command per UAV spread over the run. no text output, so the
+// numbers are the tick loop (the sinks have their own benchmarks below). args: UAVs, engine
+static void BM_Run(benchmark::State& bench) {
+	const size_t uavs = static_cast<size_t>(bench.range(0));
+	const char* engines[] = { "objects", "fleet", "analytic", "heading", "multirate" };
+	const std::string engine = engines[bench.range(1)];
+	const double timeLimit = 0.25;
+	const std::string tag = std::to_string(uavs) + "_" + engine;
+	const std::string config = writeConfig("run_" + tag + ".ini", uavs, timeLimit, "Engine = " + engine + "\nOutput = none\n");
+	const std::string commands = writeCommands("run_" + tag + ".txt", uavs, uavs, timeLimit);
+	for (auto _ : bench) {
+		Simulation sim(config, commands);
+		sim.run();
+	}
+	bench.SetLabel(engine);
+	bench.SetItemsProcessed(bench.iterations() * uavs * static_cast<int64_t>(timeLimit / 0.001));
+}
+BENCHMARK(BM_Run)->ArgsProduct({ { 4, 1000, 100000 }, { 0, 1, 2, 3, 4 } })->Unit(benchmark::kMillisecond);
+
+// ---- command file parsing ----
+
+static const std::string& commandsFile(const size_t lines) {
+	static std::map<size_t, std::string> files;
+	auto found = files.find(lines);
+	if (found == files.end())
+		found = files.emplace(lines, writeCommands("commands_" + std::to_string(lines) + ".txt", lines, 1000, 3600.)).first;
+	return found->second;
+}
+
+static void BM_ReadCommands(benchmark::State& bench) {
+	const std::string& file = commandsFile(static_cast<size_t>(bench.range(0)));
+	for (auto _ : bench) {
+		std::vector<Command> commands = Simulation::readCommandsFromFile(file, 1000);
+		benchmark::DoNotOptimize(commands.data());
+	}
+	bench.SetItemsProcessed(bench.iterations() * bench.range(0));
+	bench.SetBytesProcessed(bench.iterations() * static_cast<int64_t>(std::filesystem::file_size(file)));
+}
+BENCHMARK(BM_ReadCommands)->Arg(1000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// parse + sort as the eager source does, and the same through a CommandCache written on the first iteration
+static void BM_LoadCommands(benchmark::State& bench) {
+	const std::string& file = commandsFile(static_cast<size_t>(bench.range(0)));
+	const std::string cache = (bench.range(1) != 0) ? file + ".cache" : std::string();
+	if (!cache.empty())
+		std::remove(cache.c_str());
+	for (auto _ : bench) {
+		std::vector<Command> commands = Simulation::loadCommandsVectorFromFileSorted(file, 1000, cache);
+		benchmark::DoNotOptimize(commands.data());
+	}
+	bench.SetItemsProcessed(bench.iterations() * bench.range(0));
+}
+BENCHMARK(BM_LoadCommands)->ArgsProduct({ { 100000, 1000000 }, { 0, 1 } })->Unit(benchmark::kMillisecond);
+
+// the same files through StreamingCommandSource, drained in one go
+static void BM_StreamCommands(benchmark::State& bench) {
+	const std::string& file = commandsFile(static_cast<size_t>(bench.range(0)));
+	for (auto _ : bench) {
+		StreamingCommandSource source(file, 4096, 1000);
+		Command command;
+		while (source.pollDue(HUGE_VAL, command))
+			benchmark::DoNotOptimize(command);
+	}
+	bench.SetItemsProcessed(bench.iterations() * bench.range(0));
+	bench.SetBytesProcessed(bench.iterations() * static_cast<int64_t>(std::filesystem::file_size(file)));
+}
+BENCHMARK(BM_StreamCommands)->Arg(1000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// CommandQueue::Producer::tryPush from 1 - 4 threads while a consumer thread keeps draining, as the tick thread would
+// (a push that finds the queue full counts too, see the rejected counter)
+static void BM_CommandQueuePush(benchmark::State& bench) {
+	static CommandQueue* queue;
+	static std::atomic<bool> draining;
+	static std::thread consumer;
+	if (bench.thread_index() == 0) {
+		queue = new CommandQueue(1 << 16);
+		draining = true;
+		consumer = std::thread([] {
+			CommandQueue::Entry entry;
+			while (draining.load(std::memory_order_relaxed))
+				while (queue->tryPop(entry))
+					benchmark::DoNotOptimize(entry);
+		});
+	}
+	CommandQueue::Producer producer(*queue, static_cast<uint32_t>(bench.thread_index()));
+	const Command command(100., -100., 1., 0);
+	for (auto _ : bench)
+		benchmark::DoNotOptimize(producer.tryPush(command));
+	bench.SetItemsProcessed(bench.iterations());
+	bench.counters["rejected"] = benchmark::Counter(static_cast<double>(producer.getRejected()), benchmark::Counter::kAvgThreads);
+	if (bench.thread_index() == 0) {
+		draining = false;
+		consumer.join();
+		delete queue;
+	}
+}
+BENCHMARK(BM_CommandQueuePush)->ThreadRange(1, 4)->UseRealTime();
+
+static void BM_LoadConfig(benchmark::State& bench) {
+	const std::string config = writeConfig("load_config.ini", 4, 60.,
+		"# optional keys\nEngine = fleet\nThreads = 4\nOutput = async\nBinaryOutput = f32\nOutputStride = 10\n"
+		"OutputInterval = 0.5\nCommandInput = stream\nCommandWindow = 1024\n");
+	for (auto _ : bench) {
+		SimConfig loaded = Simulation::loadConfig(config);
+		benchmark::DoNotOptimize(loaded);
+	}
+}
+BENCHMARK(BM_LoadConfig);
+
+// ---- trajectory output ----
+
+// ticks * uavs samples of UAVs flying circles, in tick order as the tick loop produces them
+static std::vector<TrajectoryRecord> makeSamples(const size_t uavs, const size_t ticks) {
+	std::vector<TrajectoryRecord> samples;
+	samples.reserve(uavs * ticks);
+	for (size_t t = 0; t < ticks; t++) {
+		for (size_t i = 0; i < uavs; i++) {
+			const double angle = fmod(0.6 * t * 0.001 + i, 2 * M_PI);
+			samples.push_back({ t * 0.001, 500. + 100. * sin(angle) + i, 100. * cos(angle), angle });
+		}
+	}
+	return samples;
+}
+
+// formatting only (no file I/O): the text line of the async writer, and the binary column encoding
+static void BM_FormatText(benchmark::State& bench) {
+	const std::vector<TrajectoryRecord> samples = makeSamples(4, 4096);
+	char line[4 * 320];
+	for (auto _ : bench) {
+		for (const auto& s : samples)
+			benchmark::DoNotOptimize(AsyncTextTrajectorySink::formatLine(line, s));
+	}
+	bench.SetItemsProcessed(bench.iterations() * samples.size());
+}
+BENCHMARK(BM_FormatText);
+
+static void BM_EncodeBinary(benchmark::State& bench) {
+	const TrajectoryEncoding encoding = static_cast<TrajectoryEncoding>(bench.range(0));
+	const std::vector<TrajectoryRecord> samples = makeSamples(1, 4096);
+	const size_t stride = sizeof(TrajectoryRecord) / sizeof(double);
+	std::vector<unsigned char> out(trajectoryColumnBytes(encoding, true, samples.size()) + 3 * trajectoryColumnBytes(encoding, false, samples.size()));
+	for (auto _ : bench) {
+		unsigned char* p = out.data();
+		p += BinaryTrajectorySink::encodeColumn(encoding, true, &samples[0].time, stride, samples.size(), p);
+		p += BinaryTrajectorySink::encodeColumn(encoding, false, &samples[0].x, stride, samples.size(), p);
+		p += BinaryTrajectorySink::encodeColumn(encoding, false, &samples[0].y, stride, samples.size(), p);
+		BinaryTrajectorySink::encodeColumn(encoding, false, &samples[0].radianAngle, stride, samples.size(), p);
+		benchmark::ClobberMemory();
+	}
+	bench.SetItemsProcessed(bench.iterations() * samples.size());
+}
+BENCHMARK(BM_EncodeBinary)->Arg(ENCODE_F64)->Arg(ENCODE_F32)->Arg(ENCODE_DELTA32);
+
+// with file I/O: a whole sink lifetime (open, 1000 ticks of samples, close). args: UAVs
+// (wall time, the async and binary sinks do part of the work on their writer thread / at close)
+template <typename MakeSink>
+static void runSink(benchmark::State& bench, MakeSink makeSink) {
+	const size_t uavs = static_cast<size_t>(bench.range(0));
+	const std::vector<TrajectoryRecord> samples = makeSamples(uavs, 1000);
+	for (auto _ : bench) {
+		std::unique_ptr<TrajectorySink> sink = makeSink(uavs);
+		for (size_t k = 0; k < samples.size(); k++) {
+			const TrajectoryRecord& s = samples[k];
+			sink->record(k % uavs, s.time, s.x, s.y, s.radianAngle);
+			if (k % uavs == uavs - 1)
+				sink->endTick();
+		}
+		sink->close();
+	}
+	bench.SetItemsProcessed(bench.iterations() * samples.size());
+}
+
+static void BM_TextSink(benchmark::State& bench) {
+	runSink(bench, [](const size_t uavs) {
+		return std::make_unique<TextTrajectorySink>(uavs, benchDir().string());
+	});
+}
+BENCHMARK(BM_TextSink)->Arg(4)->Arg(256)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static void BM_AsyncTextSink(benchmark::State& bench) {
+	runSink(bench, [](const size_t uavs) {
+		return std::make_unique<AsyncTextTrajectorySink>(uavs, benchDir().string());
+	});
+}
+BENCHMARK(BM_AsyncTextSink)->Arg(4)->Arg(256)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static void BM_BinarySink(benchmark::State& bench) {
+	runSink(bench, [](const size_t uavs) {
+		const SimConfig config(500., 0., 500., 60., 100., 0., 1., 0.001, uavs);
+		return std::make_unique<BinaryTrajectorySink>(benchPath("bench.uavtrj"), config, ENCODE_F32);
+	});
+}
+BENCHMARK(BM_BinarySink)->Arg(4)->Arg(256)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// one interpolated point of a random UAV at a random time, from a file of 256 UAVs * 4096 samples. args: encoding
+static void BM_QueryTrajectory(benchmark::State& bench) {
+	const TrajectoryEncoding encoding = static_cast<TrajectoryEncoding>(bench.range(0));
+	const std::string file = benchPath("query" + std::to_string(encoding) + ".uavtrj");
+	{
+		const size_t uavs = 256;
+		const SimConfig config(500., 0., 500., 60., 100., 0., 1., 0.001, uavs);
+		BinaryTrajectorySink sink(file, config, encoding);
+		const std::vector<TrajectoryRecord> samples = makeSamples(uavs, 4096);
+		for (size_t k = 0; k < samples.size(); k++)
+			sink.record(k % uavs, samples[k].time, samples[k].x, samples[k].y, samples[k].radianAngle);
+	}
+	const TrajectoryReader reader(file);
+	std::mt19937_64 random(benchSeed);
+	std::uniform_int_distribution<size_t> uav(0, reader.getUavCount() - 1);
+	std::uniform_real_distribution<double> time(0., 4.095);
+	TrajectoryRecord sample;
+	for (auto _ : bench) {
+		benchmark::DoNotOptimize(reader.sampleAt(uav(random), time(random), sample));
+		benchmark::DoNotOptimize(sample);
+	}
+	bench.SetItemsProcessed(bench.iterations());
+}
+BENCHMARK(BM_QueryTrajectory)->Arg(ENCODE_F64)->Arg(ENCODE_F32)->Arg(ENCODE_DELTA32);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,116 @@
+// Validation harness for the float32 precision mode (UAV_FLOAT32): flies every scenario with BasicUAV<double>
+// and BasicUAV<float> side by side, on the same commands, and reports how far the float trajectories drift
+// from the double reference - max position and heading deviation, ticks spent in a different flight state,
+// and how many 2-decimal output lines would differ.
+//   uav_precision                          the sample scenario plus a generated 100 UAV scenario
+//   uav_precision <params> <commands> ...  the given SimParams.ini / commands file pairs
+#include "Simulation.h"
+#include "VectorCommandSource.h"
+#include "AsyncTextTrajectorySink.h"
+#include <random>
+
+#ifndef UAV_SAMPLE_DIR
+#define UAV_SAMPLE_DIR "UAV_Simulation"
+#endif
+
+struct Deviation {
+	double position = 0., positionTime = 0.;
+	size_t positionUav = 0;
+	double heading = 0.; // degrees
+	size_t stateTicks = 0, lines = 0, samples = 0;
+};
+
+// heading difference in degrees, wrapped to [0, 180]
+static double headingDifference(const double a, const double b) {
+	const double d = fmod(fabs(a - b), 2 * M_PI);
+	return ((d > M_PI) ? 2 * M_PI - d : d) * 180. / M_PI;
+}
+
+static Deviation compare(const SimConfig& config, std::vector<Command> sortedCommands) {
+	const BasicAirframe<double> referenceAirframe(config.getV0(), config.getR0(), config.getDt());
+	const BasicAirframe<float> singleAirframe(config.getV0(), config.getR0(), config.getDt());
+	std::vector<BasicUAV<double>> reference;
+	std::vector<BasicUAV<float>> single;
+	for (size_t i = 0; i < config.getTotalUavs(); i++) {
+		reference.emplace_back(i, config.getX(), config.getY(), config.getAngleRad(), referenceAirframe);
+		single.emplace_back(i, config.getX(), config.getY(), config.getAngleRad(), singleAirframe);
+	}
+	VectorCommandSource source(std::move(sortedCommands));
+	CommandScheduler scheduler(source, config.getTotalUavs());
+	Deviation deviation;
+	char lineDouble[1280], lineFloat[1280];
+	for (double currentTime = 0.; currentTime < config.getTimeLimit(); currentTime += config.getDt()) {
+		for (const Command& command : scheduler.collect(currentTime)) {
+			reference[command.getUavNum()].acceptCommand(command);
+			single[command.getUavNum()].acceptCommand(command);
+		}
+		for (size_t i = 0; i < reference.size(); i++) {
+			BasicUAV<double>& d = reference[i];
+			BasicUAV<float>& f = single[i];
+			d.flightStep(currentTime);
+			f.flightStep(currentTime);
+			const double distance = hypot(double(f.getX()) - d.getX(), double(f.getY()) - d.getY());
+			if (distance > deviation.position) {
+				deviation.position = distance;
+				deviation.positionTime = currentTime;
+				deviation.positionUav = i;
+			}
+			deviation.heading = std::max(deviation.heading, headingDifference(f.getAngleRad(), d.getAngleRad()));
+			deviation.stateTicks += (f.getState() != d.getState());
+			const size_t lengthDouble = AsyncTextTrajectorySink::formatLine(lineDouble, { currentTime, d.getX(), d.getY(), d.getAngleRad() });
+			const size_t lengthFloat = AsyncTextTrajectorySink::formatLine(lineFloat, { currentTime, f.getX(), f.getY(), f.getAngleRad() });
+			deviation.lines += (lengthDouble != lengthFloat || memcmp(lineDouble, lineFloat, lengthDouble) != 0);
+			deviation.samples++;
+		}
+	}
+	return deviation;
+}
+
+static void report(const std::string& name, const Deviation& d) {
+	std::cout << name << ":\n" << std::fixed << std::setprecision(6)
+		<< "  max position deviation " << d.position << " (UAV " << d.positionUav << " at t = " << std::setprecision(3) << d.positionTime << ")\n"
+		<< std::setprecision(6) << "  max heading deviation  " << d.heading << " deg\n"
+		<< "  different flight state " << d.stateTicks << " of " << d.samples << " samples\n"
+		<< "  different output lines " << d.lines << " of " << d.samples << " (" << std::setprecision(3)
+		<< ((d.samples > 0) ? 100. * d.lines / d.samples : 0.) << "%)\n";
+}
+
+// 100 UAVs from the sample starting point, 400 commands at random times and places (fixed seed)
+static void generatedScenario(SimConfig& config, std::vector<Command>& commands) {
+	config = SimConfig(500., 0., 500., 60., 100., 0., 60., 0.001, 100);
+	std::mt19937_64 random(20240601);
+	std::uniform_real_distribution<double> time(0., 60.), place(-2000., 2000.);
+	std::uniform_int_distribution<size_t> uav(0, 99);
+	for (size_t i = 0; i < 400; i++)
+		commands.emplace_back(place(random), place(random), floor(time(random) * 10.) / 10., uav(random));
+	std::reverse(commands.begin(), commands.end());
+	std::stable_sort(commands.begin(), commands.end(), Command::later);
+}
+
+int main(int argc, char* argv[])
+try {
+	std::cout << "UAV state: " << sizeof(BasicUAV<double>) << " bytes as double, " << sizeof(BasicUAV<float>) << " bytes as float\n\n";
+	if (argc > 1) {
+		if (argc % 2 != 1) {
+			std::cerr << "usage: uav_precision [<params> <commands>]..." << '\n';
+			return 1;
+		}
+		for (int i = 1; i + 1 < argc; i += 2) {
+			const SimConfig config = Simulation::loadConfig(argv[i]);
+			report(argv[i], compare(config, Simulation::loadCommandsVectorFromFileSorted(argv[i + 1], config.getTotalUavs())));
+		}
+		return 0;
+	}
+	const std::string sample = UAV_SAMPLE_DIR;
+	const SimConfig sampleConfig = Simulation::loadConfig(sample + "/SimParams.ini");
+	report("sample scenario", compare(sampleConfig, Simulation::loadCommandsVectorFromFileSorted(sample + "/simCmds.txt", sampleConfig.getTotalUavs())));
+	SimConfig config;
+	std::vector<Command> commands;
+	generatedScenario(config, commands);
+	report("generated scenario (100 UAVs, 400 commands)", compare(config, std::move(commands)));
+	return 0;
+}
+catch (const std::exception& e) {
+	std::cerr << "Error: " << e.what() << '\n';
+	return 1;
+}